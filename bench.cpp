@@ -0,0 +1,174 @@
+// MIT License
+
+// Copyright (c) 2023 Ariyudo Pertama
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "bench.h"
+
+
+// Time debug(...) from 1 to 64 threads at once, with and without DEBUG::async, into /dev/null and a RING_SINK.
+// Then time it on every container overload, from 10 elements up to the count given on the command line
+// (default 10^7), at unfold depths 0, 1 and 8, into /dev/null, a RING_SINK and a file. Build with:
+// g++ -std=c++17 -O2 -I<include> bench.cpp -o bench && ./bench [max_elements]
+
+// Counts the bytes of every record, to turn times into bytes per second.
+class COUNT_SINK : public DEBUG_SINK
+{
+public:
+    size_t bytes = 0;
+
+    void write(std::string_view _record) override
+        { bytes += _record.size(); }
+};
+
+struct output
+{
+    const char* name;
+    std::function<std::shared_ptr<DEBUG_SINK>()> make;
+};
+
+// Records per second written by _threads threads that all call debug(i) for half a second.
+static double measure_threads(size_t _threads)
+{
+    std::atomic<bool> running{true};
+    std::atomic<size_t> records{0};
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < _threads; t++)
+        workers.emplace_back([&]()
+        {
+            size_t count = 0;
+            for (int i = 0; running.load(std::memory_order_relaxed); i++, count++)
+                debug(i);
+            records += count;
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    running = false;
+    for (std::thread& worker : workers)
+        worker.join();
+    DEBUG::flush();
+    return records / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename _Tp>
+static void measure(const char* _name, size_t _elements, const _Tp& _item, const std::vector<output>& _outputs)
+{
+    for (int depth : {0, 1, 8})
+    {
+        auto count = std::make_shared<COUNT_SINK>();
+        DEBUG::sink(count);
+        debug(_item)(depth);
+        size_t bytes = count->bytes;
+
+        for (const output& out : _outputs)
+        {
+            DEBUG::sink(out.make());
+            debug(_item)(depth);
+
+            size_t calls   = 0;
+            size_t before  = allocations;
+            double seconds = time_call([&]() { debug(_item)(depth); calls++; }, 0.2);
+            std::printf("%-20s %9zu %6d %-8s %10.2f %10.1f %10.2f\n", _name, _elements, depth, out.name,
+                        seconds * 1e9 / std::max<size_t>(_elements, 1), bytes / seconds / 1e6,
+                        static_cast<double>(allocations - before) / calls);
+        }
+    }
+    DEBUG::sink(nullptr);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t max_elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    const char* path    = "bench.out";
+
+    int null = ::open("/dev/null", O_WRONLY);
+    int file = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (null < 0 || file < 0)
+    {
+        std::cerr << argv[0] << ": cannot open /dev/null or " << path << '\n';
+        return 1;
+    }
+    std::vector<output> outputs = {
+        {"null",   [&]() { return std::make_shared<FD_SINK>(null); }},
+        {"memory", [&]() { return std::make_shared<RING_SINK>(1 << 26); }},
+        {"file",   [&]() { return ::ftruncate(file, 0), ::lseek(file, 0, SEEK_SET), std::make_shared<FD_SINK>(file); }}
+    };
+
+    std::printf("%7s %-8s %-6s %12s\n", "threads", "output", "mode", "records/s");
+    for (size_t threads = 1; threads <= 64; threads *= 2)
+        for (const output& out : {outputs[0], outputs[1]})
+            for (bool async : {false, true})
+            {
+                DEBUG::sink(out.make());
+                if (async)
+                    DEBUG::async();
+                double rate = measure_threads(threads);
+                DEBUG::shutdown();
+                std::printf("%7zu %-8s %-6s %12.0f\n", threads, out.name, async ? "async" : "sync", rate);
+            }
+    DEBUG::sink(nullptr);
+    std::printf("\n");
+
+    std::printf("%-20s %9s %6s %-8s %10s %10s %10s\n", "container", "elements", "depth", "output", "ns/elem",
+                "MB/s", "allocs");
+    measure("pair", 2, std::make_pair(value(1), value(2)), outputs);
+    measure("tuple", 3, std::make_tuple(value(1), value(2), value(3)), outputs);
+
+    for (size_t n = 10; n <= max_elements; n *= 10)
+    {
+        // Each container is built and freed before the next one, so only one of them is in memory at a time.
+        auto fill = [&](auto& _item, auto _insert) { for (size_t i = 0; i < n; i++) _insert(_item, i); };
+        auto with = [&](const char* _name, auto _item, auto _insert) { fill(_item, _insert); measure(_name, n, _item, outputs); };
+
+        with("vector", std::vector<int>(), [](auto& _c, size_t _i) { _c.push_back(value(_i)); });
+        with("vector<pair>", std::vector<std::pair<int, int>>(),
+             [](auto& _c, size_t _i) { _c.emplace_back(value(_i), value(_i + 1)); });
+        with("vector<tuple>", std::vector<std::tuple<int, int, int>>(),
+             [](auto& _c, size_t _i) { _c.emplace_back(value(_i), value(_i + 1), value(_i + 2)); });
+        with("vector<vector>", std::vector<std::vector<int>>(),
+             [](auto& _c, size_t _i) { if (_i % 10 == 0) _c.emplace_back(); _c.back().push_back(value(_i)); });
+        with("set", std::set<int>(), [](auto& _c, size_t _i) { _c.insert(value(_i)); });
+        with("multiset", std::multiset<int>(), [](auto& _c, size_t _i) { _c.insert(value(_i / 2)); });
+        with("map", std::map<int, int>(), [](auto& _c, size_t _i) { _c.emplace(value(_i), value(_i + 1)); });
+        with("multimap", std::multimap<int, int>(), [](auto& _c, size_t _i) { _c.emplace(value(_i / 2), value(_i)); });
+        with("map<int, vector>", std::map<int, std::vector<int>>(),
+             [](auto& _c, size_t _i) { _c[static_cast<int>(_i / 10)].push_back(value(_i)); });
+        with("unordered_set", std::unordered_set<int>(), [](auto& _c, size_t _i) { _c.insert(value(_i)); });
+        with("unordered_multiset", std::unordered_multiset<int>(), [](auto& _c, size_t _i) { _c.insert(value(_i / 2)); });
+        with("unordered_map", std::unordered_map<int, int>(),
+             [](auto& _c, size_t _i) { _c.emplace(value(_i), value(_i + 1)); });
+        with("unordered_multimap", std::unordered_multimap<int, int>(),
+             [](auto& _c, size_t _i) { _c.emplace(value(_i / 2), value(_i)); });
+        with("stack", std::stack<int>(), [](auto& _c, size_t _i) { _c.push(value(_i)); });
+        with("queue", std::queue<int>(), [](auto& _c, size_t _i) { _c.push(value(_i)); });
+        with("deque", std::deque<int>(), [](auto& _c, size_t _i) { _c.push_back(value(_i)); });
+        with("priority_queue", std::priority_queue<int>(), [](auto& _c, size_t _i) { _c.push(value(_i)); });
+        with("pbds tree",
+             __gnu_pbds::tree<int, __gnu_pbds::null_type, std::less<int>, __gnu_pbds::rb_tree_tag,
+                              __gnu_pbds::tree_order_statistics_node_update>(),
+             [](auto& _c, size_t _i) { _c.insert(value(_i)); });
+    }
+
+    ::close(null);
+    ::close(file);
+    ::unlink(path);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// MIT License
+
+// Copyright (c) 2023 Ariyudo Pertama
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef _TLE_BENCH_H
+#define _TLE_BENCH_H 1
+
+#include <tle/debug>
+#include <new>
+
+
+// Helpers shared by bench.cpp and debug_check.cpp. The replaced operator new and delete are defined here,
+// so only one file of a program may include this header.
+
+static size_t allocations = 0;
+
+void* operator new(size_t _size)
+{
+    allocations++;
+    if (void* pointer = std::malloc(std::max<size_t>(_size, 1)))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t _size)
+    { return operator new(_size); }
+
+// Not inlined, so that GCC does not take the free() for a mismatched delete of memory from new[].
+__attribute__((noinline)) void operator delete(void* _pointer) noexcept
+    { std::free(_pointer); }
+
+void operator delete[](void* _pointer) noexcept
+    { operator delete(_pointer); }
+
+void operator delete(void* _pointer, size_t) noexcept
+    { operator delete(_pointer); }
+
+void operator delete[](void* _pointer, size_t) noexcept
+    { operator delete(_pointer); }
+
+
+static int value(size_t _index)
+{
+    return static_cast<int>(_index * 2654435761u % 1000000007u);
+}
+
+// Seconds per call of _call, repeated until the run takes at least _seconds.
+template <typename _Call>
+static double time_call(_Call _call, double _seconds = 0.5)
+{
+    size_t repeats = 0;
+    auto start     = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < _seconds)
+    {
+        for (size_t i = std::max<size_t>(repeats, 1); i--; repeats++)
+            _call();
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return elapsed / repeats;
+}
+
+
+#endif /* _TLE_BENCH_H */
@@ -25,321 +25,2703 @@
 #define _TLE_DEBUG_CPP 1
 
 
+#if DEBUG_DEFINITIONS
+const DEBUG::palette DEBUG::colored_palette = DEBUG::make_palette(false);
+const DEBUG::palette DEBUG::plain_palette   = DEBUG::make_palette(true);
+const DEBUG::palette DEBUG::json_palette    = DEBUG::make_json_palette();
+std::atomic<bool> DEBUG::sink_terminal{STREAM_SINK(std::cout).terminal()};
+
+std::mutex DEBUG::output_mutex;
+std::recursive_mutex DEBUG::watch_mutex;
+
+std::atomic<PROBE*> PROBE::probes{nullptr};
+
+#ifdef DEBUG_POSIX
+std::atomic<RING_SINK*> RING_SINK::crash_sink{nullptr};
+#endif
+
+
+// Sinks
+void DEBUG_SINK::write_all(const std::string_view* _records, size_t _count)
+{
+    for (size_t i = 0; i < _count; i++)
+        write(_records[i]);
+}
+
+void DEBUG_SINK::flush()
+    {}
+
+bool DEBUG_SINK::terminal() const
+    { return false; }
+
+#ifdef DEBUG_POSIX
+STREAM_SINK::STREAM_SINK(std::ostream& _stream)
+    : stream(_stream),
+      tty(&_stream == &std::cout ? ::isatty(STDOUT_FILENO) :
+          &_stream == &std::cerr || &_stream == &std::clog ? ::isatty(STDERR_FILENO) : false)
+    {}
+#else
+STREAM_SINK::STREAM_SINK(std::ostream& _stream)
+    : stream(_stream), tty(&_stream == &std::cout || &_stream == &std::cerr || &_stream == &std::clog)
+    {}
+#endif
+
+void STREAM_SINK::write(std::string_view _record)
+    { stream.write(_record.data(), _record.size()); }
+
+void STREAM_SINK::flush()
+    { stream.flush(); }
+
+bool STREAM_SINK::terminal() const
+    { return tty; }
+
+RING_SINK::RING_SINK(size_t _capacity)
+    : buffer(new char[std::max<size_t>(_capacity, 1)]), capacity(std::max<size_t>(_capacity, 1))
+    {}
+
+void RING_SINK::write(std::string_view _record)
+{
+    if (_record.size() > capacity)
+        _record.remove_prefix(_record.size() - capacity);
+
+    size_t start = written % capacity;
+    size_t first = std::min(_record.size(), capacity - start);
+    std::memcpy(buffer.get() + start, _record.data(), first);
+    std::memcpy(buffer.get(), _record.data() + first, _record.size() - first);
+    written += _record.size();
+}
+
+void RING_SINK::dump(std::ostream& _stream) const
+{
+    size_t start = written > capacity ? written % capacity : 0;
+    size_t size  = std::min(written, capacity);
+    _stream.write(buffer.get() + start, std::min(size, capacity - start));
+    _stream.write(buffer.get(), size - std::min(size, capacity - start));
+    _stream.flush();
+}
+
+#ifdef DEBUG_POSIX
+void RING_SINK::dump(int _fd) const
+{
+    size_t start = written > capacity ? written % capacity : 0;
+    size_t size  = std::min(written, capacity);
+    iovec parts[2] = {
+        {buffer.get() + start, std::min(size, capacity - start)},
+        {buffer.get(), size - std::min(size, capacity - start)}
+    };
+    ::writev(_fd, parts, 2);
+}
+
+RING_SINK::~RING_SINK()
+{
+    RING_SINK* sink = this;
+    crash_sink.compare_exchange_strong(sink, nullptr);
+}
+
+// The handler is reset before it runs, so raising the signal again ends the process as it would have without it.
+void RING_SINK::dump_on_crash()
+{
+    crash_sink.store(this);
+
+    struct sigaction action = {};
+    action.sa_handler = dump_crash;
+    action.sa_flags   = SA_RESETHAND | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    for (int signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT})
+        ::sigaction(signal, &action, nullptr);
+}
+
+void RING_SINK::dump_crash(int _signal)
+{
+    if (RING_SINK* sink = crash_sink.exchange(nullptr))
+        sink->dump(STDERR_FILENO);
+    ::raise(_signal);
+}
+
+FD_SINK::FD_SINK(int _fd)
+    : fd(_fd), tty(::isatty(_fd))
+    {}
+
+bool FD_SINK::terminal() const
+    { return tty; }
+
+void FD_SINK::write_fully(const char* _data, size_t _size)
+{
+    while (_size)
+    {
+        ssize_t result = ::write(fd, _data, _size);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return;
+        _data += result, _size -= result;
+    }
+}
+
+void FD_SINK::write(std::string_view _record)
+    { write_fully(_record.data(), _record.size()); }
+
+void FD_SINK::write_all(const std::string_view* _records, size_t _count)
+{
+#ifdef IOV_MAX
+    constexpr size_t parts_max = IOV_MAX < 64 ? IOV_MAX : 64;
+#else
+    constexpr size_t parts_max = 16;
+#endif
+
+    while (_count)
+    {
+        iovec parts[parts_max];
+        size_t count = std::min(_count, parts_max);
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            parts[i] = {const_cast<char*>(_records[i].data()), _records[i].size()};
+            total   += _records[i].size();
+        }
+
+        ssize_t result = ::writev(fd, parts, count);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0)
+            return;
+        for (size_t i = 0, done = result; i < count; done -= std::min(done, _records[i].size()), i++)
+            if (done < _records[i].size())
+                write_fully(_records[i].data() + done, _records[i].size() - done);
+        _records += count, _count -= count;
+    }
+}
+
+MMAP_SINK::MMAP_SINK(const char* _path, size_t _capacity)
+{
+    fd = ::open(_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return;
+
+    off_t end = ::lseek(fd, 0, SEEK_END);
+    if (end < 0)
+        return;
+    size = end;
+    grow(std::max<size_t>(_capacity, 1));
+}
+
+MMAP_SINK::~MMAP_SINK()
+{
+    if (data)
+        ::munmap(data, capacity);
+    if (fd >= 0)
+        ::ftruncate(fd, size), ::close(fd);
+}
+
+// Makes room for at least _bytes more, doubling the file so that appends stay amortized O(1).
+bool MMAP_SINK::grow(size_t _bytes)
+{
+    size_t target = std::max(size + _bytes, capacity * 2);
+    if (fd < 0 || ::ftruncate(fd, target) != 0)
+        return false;
+
+#ifdef MREMAP_MAYMOVE
+    void* address = data ? ::mremap(data, capacity, target, MREMAP_MAYMOVE)
+                         : ::mmap(nullptr, target, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#else
+    if (data)
+        ::munmap(data, capacity), data = nullptr, capacity = 0;
+    void* address = ::mmap(nullptr, target, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+    if (address == MAP_FAILED)
+        return false;
+    data     = static_cast<char*>(address);
+    capacity = target;
+    return true;
+}
+
+void MMAP_SINK::write(std::string_view _record)
+{
+    if (size + _record.size() > capacity && !grow(_record.size()))
+        return void(dropped++);
+    std::memcpy(data + size, _record.data(), _record.size());
+    size += _record.size();
+}
+
+void MMAP_SINK::flush()
+{
+    if (data)
+        ::msync(data, capacity, MS_ASYNC);
+}
+
+bool MMAP_SINK::good() const
+    { return data != nullptr; }
+
+size_t MMAP_SINK::dropped_records() const
+    { return dropped; }
+#endif
+std::atomic<size_t> DEBUG::thread_count{0};
+std::atomic<size_t> DEBUG::record_count{0};
+#endif
+
+
+// Label Parsing
+constexpr bool DEBUG::split_label(char _c, int& _indent_depth, bool& _on_quote, bool& _on_double_quote)
+{
+    _indent_depth    += _c == '(' || _c == '{' || _c == '[' || _c == '<';
+    _indent_depth    -= _c == ')' || _c == '}' || _c == ']' || _c == '>';
+    _on_quote        ^= _c == '\'';
+    _on_double_quote ^= _c == '\"';
+    return _c == ',' && !_indent_depth && !_on_quote && !_on_double_quote;
+}
+
+template <size_t _Length>
+constexpr DEBUG::label_text<_Length> DEBUG::strip_labels(const char (&_label)[_Length])
+{
+    label_text<_Length> text;
+    int  indent_depth    = 0;
+    bool on_quote        = false;
+    bool on_double_quote = false;
+
+    for (size_t i = 0; i + 1 < _Length; i++)
+    {
+        if (_label[i] == ' ' && !on_quote && !on_double_quote)
+            continue;
+        split_label(_label[i], indent_depth, on_quote, on_double_quote);
+        text.data[text.size++] = _label[i];
+    }
+    return text;
+}
+
+constexpr size_t DEBUG::count_labels(std::string_view _label)
+{
+    size_t count         = 1;
+    int  indent_depth    = 0;
+    bool on_quote        = false;
+    bool on_double_quote = false;
+
+    for (char c : _label)
+        count += split_label(c, indent_depth, on_quote, on_double_quote);
+    return count;
+}
+
+template <size_t _Count, size_t _Length>
+constexpr std::array<std::string_view, _Count> DEBUG::split_labels(const label_text<_Length>& _text)
+{
+    std::array<std::string_view, _Count> labels{};
+    size_t index         = 0;
+    size_t start         = 0;
+    int  indent_depth    = 0;
+    bool on_quote        = false;
+    bool on_double_quote = false;
+
+    for (size_t i = 0; i < _text.size; i++)
+    {
+        if (!split_label(_text.data[i], indent_depth, on_quote, on_double_quote))
+            continue;
+        labels[index++] = std::string_view(_text.data + start, i - start);
+        start = i + 1;
+    }
+    labels[index] = std::string_view(_text.data + start, _text.size - start);
+    return labels;
+}
+
+template <typename... _Tps>
+std::tuple<_Tps...> DEBUG::capture_fields(_Tps&&... _fields)
+{
+    return std::tuple<_Tps...>(std::forward<_Tps>(_fields)...);
+}
+
+// Bit-fields cannot bind to a forwarding reference, but a const reference
+// binds to a temporary copy that lives until the end of the debug statement.
+template <typename... _Tps>
+std::tuple<const _Tps&...> DEBUG::capture_items(const _Tps&... _items)
+{
+    return std::tuple<const _Tps&...>(_items...);
+}
+
+
 // Constructor and Destructor
+#if DEBUG_DEFINITIONS
 DEBUG::DEBUG()
     {}
+#endif
 
-template <typename... _Tps>
-DEBUG::DEBUG(std::string _label, const _Tps&... _items)
-    : label(_label), delayed_print([&, _items...]() { return print_output(_items...); })
+template <size_t _Count, typename... _Tps>
+DEBUG::DEBUG(const std::array<std::string_view, _Count>& _labels, const std::tuple<_Tps...>& _items)
+    : labels(_labels.data()), label_count(_Count), items(&_items), delayed_print(&DEBUG::print_items<_Tps...>)
     {}
 
+template <size_t _Count, typename... _Tps>
+DEBUG::DEBUG(const std::array<std::string_view, _Count>& _labels, const std::tuple<_Tps...>& _items, uint64_t _suppressed)
+    : DEBUG(_labels, _items)
+    { suppressed = _suppressed; }
+
+#if DEBUG_DEFINITIONS
 DEBUG::~DEBUG()
 {
-    depth *= !force_horizontal;
-    generate_labels(label);
-    delayed_print();
+    if (delayed_print)
+        print_delayed();
+}
+
+
+// Output
+void DEBUG::write(std::string_view _record)
+{
+    if (trace().file.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        if (std::FILE* file = trace().file.load(std::memory_order_relaxed))
+            return write_frame(file, frame::text, _record);
+    }
+
+    if (queue_record(_record))
+        return;
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    current_sink()->write(_record);
+}
+
+void DEBUG::async(size_t _queue_depth, DEBUG_POLICY _policy)
+{
+    shutdown();
+
+    async_queue& q = queue();
+    q.capacity = std::max<size_t>(_queue_depth, 1);
+    q.policy   = _policy;
+    q.slots.reset(new async_slot[q.capacity]);
+    for (size_t i = 0; i < q.capacity; i++)
+        q.slots[i].sequence.store(i, std::memory_order_relaxed);
+    q.head.store(0, std::memory_order_relaxed);
+    q.tail.store(0, std::memory_order_relaxed);
+    q.running.store(true, std::memory_order_release);
+    q.worker = std::thread(drain_records);
+}
+
+void DEBUG::flush()
+{
+    async_queue& q = queue();
+    size_t head = q.head.load(std::memory_order_acquire);
+    while (q.running.load(std::memory_order_acquire) && q.tail.load(std::memory_order_acquire) < head)
+        std::this_thread::yield();
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    current_sink()->flush();
+    if (std::FILE* file = trace().file.load(std::memory_order_relaxed))
+        std::fflush(file);
+}
+
+void DEBUG::shutdown()
+{
+    async_queue& q = queue();
+    if (!q.running.exchange(false))
+        return;
+    q.worker.join();
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    current_sink()->flush();
+}
+
+void DEBUG::sink(std::shared_ptr<DEBUG_SINK> _sink)
+{
+    if (!_sink)
+        _sink = std::make_shared<STREAM_SINK>(std::cout);
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    current_sink()->flush();
+    current_sink().swap(_sink);
+    sink_terminal.store(current_sink()->terminal(), std::memory_order_relaxed);
+}
+
+bool DEBUG::binary_trace(const char* _path)
+{
+    trace_state& t = trace();
+    std::lock_guard<std::mutex> lock(output_mutex);
+    if (std::FILE* file = t.file.exchange(nullptr, std::memory_order_acq_rel))
+        std::fclose(file);
+    t.labels.clear();
+    if (!_path)
+        return true;
+
+    std::FILE* file = std::fopen(_path, "wb");
+    if (!file)
+        return false;
+    std::fwrite(TRACE_MAGIC.data(), 1, TRACE_MAGIC.size(), file);
+    t.file.store(file, std::memory_order_release);
+    return true;
+}
+
+bool DEBUG::decode(std::istream& _input)
+{
+    std::string magic(TRACE_MAGIC.size(), '\0');
+    if (!_input.read(magic.data(), magic.size()) || magic != TRACE_MAGIC)
+        return false;
+
+    std::deque<std::string> label_storage;
+    std::vector<std::vector<std::string_view>> label_table;
+    std::string payload;
+    char head[5];
+    while (_input.read(head, sizeof(head)))
+    {
+        const char* cursor = head + 1;
+        payload.resize(get_integer(cursor, 4));
+        if (!_input.read(payload.data(), payload.size()))
+            return false;
+        cursor = payload.data();
+        const char* last = payload.data() + payload.size();
+
+        // Every length and index comes from the file, so each one is checked against the frame before it is used.
+        if (static_cast<frame>(head[0]) == frame::text)
+            write(payload);
+        else if (static_cast<frame>(head[0]) == frame::labels)
+        {
+            if (!available(cursor, last, 4))
+                return false;
+            size_t count = get_integer(cursor, 4);
+            if (count > static_cast<size_t>(last - cursor) / 4)
+                return false;
+            std::vector<std::string_view>& labels = label_table.emplace_back(count);
+            for (std::string_view& label : labels)
+            {
+                if (!available(cursor, last, 4))
+                    return false;
+                size_t size = get_integer(cursor, 4);
+                if (!available(cursor, last, size))
+                    return false;
+                label = label_storage.emplace_back(cursor, size);
+                cursor += size;
+            }
+        }
+        else if (static_cast<frame>(head[0]) == frame::record)
+        {
+            size_t index = available(cursor, last, 4) ? get_integer(cursor, 4) : SIZE_MAX;
+            if (index >= label_table.size())
+                return false;
+            DEBUG record;
+            record.labels      = label_table[index].data();
+            record.label_count = label_table[index].size();
+            if (!record.replay_record(cursor, last))
+                return false;
+        }
+        else
+            return false;
+    }
+    return _input.eof();
+}
+
+
+// Asynchronous Output
+DEBUG::async_queue::async_queue()
+{
+    // The queue drains into the sink when it is destroyed, so the sink has to be constructed first to outlive it.
+    current_sink();
+}
+
+DEBUG::async_queue::~async_queue()
+    { DEBUG::shutdown(); }
+
+DEBUG::async_queue& DEBUG::queue()
+{
+    static async_queue q;
+    return q;
+}
+
+std::shared_ptr<DEBUG_SINK>& DEBUG::current_sink()
+{
+    static std::shared_ptr<DEBUG_SINK> sink = std::make_shared<STREAM_SINK>(std::cout);
+    return sink;
+}
+
+
+// Colors
+const DEBUG::palette& DEBUG::current_palette()
+{
+    if (DEBUG_OUTPUT_STYLE == DEBUG_AUTO)
+        return sink_terminal.load(std::memory_order_relaxed) ? colored_palette : plain_palette;
+    if (DEBUG_OUTPUT_STYLE == DEBUG_JSON)
+        return json_palette;
+    return DEBUG_OUTPUT_STYLE == DEBUG_PLAIN ? plain_palette : colored_palette;
+}
+
+DEBUG::palette DEBUG::make_palette(bool _plain)
+{
+    auto token = [&](const std::string& _token) { return _plain ? strip_colors(_token) : _token; };
+    auto tokens = [&](const std::string& _open, const std::string& _separator, const std::string& _close)
+        { return token_set{token(_open), token(_separator), token(_close)}; };
+
+    return palette{
+        token(DEBUG_HEADING),
+        token(DEBUG_EQUAL),
+        token(DEBUG_UNFOLD),
+        token(RECORD_OPEN),
+        token(RECORD_CLOSE),
+        token(RECORD_DROPPED),
+        token(RECORD_SUPPRESSED),
+        token(LABEL_OPEN),
+        token(LABEL_CLOSE),
+        token(POINTER_MARK),
+        token(ITERATOR_MARK),
+        token(ELLIPSIS_OPEN),
+        token(ELLIPSIS_CLOSE),
+        token(REMOVED_OPEN),
+        token(REMOVED_CLOSE),
+        {
+            tokens(PAIR_OPEN,               PAIR_SEPARATOR,               PAIR_CLOSE),
+            tokens(TUPLE_OPEN,              TUPLE_SEPARATOR,              TUPLE_CLOSE),
+            tokens(VECTOR_OPEN,             VECTOR_SEPARATOR,             VECTOR_CLOSE),
+            tokens(SET_OPEN,                SET_SEPARATOR,                SET_CLOSE),
+            tokens(MULTISET_OPEN,           MULTISET_SEPARATOR,           MULTISET_CLOSE),
+            tokens(MAP_OPEN,                MAP_SEPARATOR,                MAP_CLOSE),
+            tokens(MULTIMAP_OPEN,           MULTIMAP_SEPARATOR,           MULTIMAP_CLOSE),
+            tokens(UNORDERED_SET_OPEN,      UNORDERED_SET_SEPARATOR,      UNORDERED_SET_CLOSE),
+            tokens(UNORDERED_MULTISET_OPEN, UNORDERED_MULTISET_SEPARATOR, UNORDERED_MULTISET_CLOSE),
+            tokens(UNORDERED_MAP_OPEN,      UNORDERED_MAP_SEPARATOR,      UNORDERED_MAP_CLOSE),
+            tokens(UNORDERED_MULTIMAP_OPEN, UNORDERED_MULTIMAP_SEPARATOR, UNORDERED_MULTIMAP_CLOSE),
+            tokens(STACK_OPEN,              STACK_SEPARATOR,              STACK_CLOSE),
+            tokens(QUEUE_OPEN,              QUEUE_SEPARATOR,              QUEUE_CLOSE),
+            tokens(DEQUE_OPEN,              DEQUE_SEPARATOR,              DEQUE_CLOSE),
+            tokens(PRIORITY_QUEUE_OPEN,     PRIORITY_QUEUE_SEPARATOR,     PRIORITY_QUEUE_CLOSE),
+            tokens(PRIORITY_QUEUE_OPEN,     PRIORITY_QUEUE_SEPARATOR,     PRIORITY_QUEUE_CLOSE),
+            tokens(STRUCT_OPEN,             STRUCT_SEPARATOR,             STRUCT_CLOSE),
+            tokens(RANGE_OPEN,              RANGE_SEPARATOR,              RANGE_CLOSE)
+        }
+    };
+}
+
+DEBUG::palette DEBUG::make_json_palette()
+{
+    token_set array{JSON_ARRAY_OPEN, JSON_SEPARATOR, JSON_ARRAY_CLOSE};
+    token_set object{JSON_OBJECT_OPEN, JSON_SEPARATOR, JSON_OBJECT_CLOSE};
+
+    // Pairs, tuples and every container are arrays; maps are arrays of [key, value] pairs.
+    return palette{
+        "",
+        JSON_EQUAL,
+        "",
+        JSON_RECORD_OPEN,
+        "",
+        JSON_RECORD_DROPPED,
+        JSON_RECORD_SUPPRESSED,
+        JSON_QUOTE,
+        JSON_QUOTE,
+        "",
+        "",
+        JSON_ELLIPSIS_OPEN,
+        JSON_ELLIPSIS_CLOSE,
+        JSON_REMOVED_OPEN,
+        JSON_REMOVED_CLOSE,
+        {array, array, array, array, array, array, array, array, array,
+         array, array, array, array, array, array, array, object, array}
+    };
+}
+
+std::string DEBUG::strip_colors(const std::string& _token)
+{
+    std::string plain;
+    for (size_t i = 0; i < _token.size(); i++)
+    {
+        if (_token[i] != '\x1B')
+        {
+            plain += _token[i];
+            continue;
+        }
+        while (i < _token.size() && _token[i] != 'm')
+            i++;
+    }
+    return plain;
+}
+
+bool DEBUG::queue_record(std::string_view _record, const std::string_view* _labels, size_t _label_count)
+{
+    // A producer announces itself before checking that the queue runs, so a
+    // concurrent shutdown() waits for its record instead of losing it.
+    async_queue& q = queue();
+    if (!q.running.load(std::memory_order_relaxed))
+        return false;
+    q.producers.fetch_add(1);
+    bool queued = q.running.load() && (push_record(_record, _labels, _label_count), true);
+    q.producers.fetch_sub(1);
+    return queued;
+}
+
+void DEBUG::push_record(std::string_view _record, const std::string_view* _labels, size_t _label_count)
+{
+    async_queue& q = queue();
+    size_t position = q.head.load(std::memory_order_relaxed);
+    async_slot* slot;
+    while (true)
+    {
+        slot = &q.slots[position % q.capacity];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+            if (q.head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (sequence < position)
+        {
+            if (q.policy == DEBUG_DROP)
+                return void(q.dropped.fetch_add(1, std::memory_order_relaxed));
+            std::this_thread::yield();
+            position = q.head.load(std::memory_order_relaxed);
+        }
+        else
+            position = q.head.load(std::memory_order_relaxed);
+    }
+    slot->record.assign(_record);
+    slot->labels      = _labels;
+    slot->label_count = _label_count;
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void DEBUG::render_slot(async_slot& _slot)
+{
+    // The slot holds a record in the binary encoding of debug(...); it is replaced by its text.
+    DEBUG record;
+    record.labels      = std::exchange(_slot.labels, nullptr);
+    record.label_count = _slot.label_count;
+    record.output.swap(record_buffer());
+    if (!record.render_record(_slot.record.data() + 4, _slot.record.data() + _slot.record.size()))
+        record.output.clear();
+    _slot.record.swap(record.output);
+    record.output.clear();
+    record.output.swap(record_buffer());
+}
+
+void DEBUG::drain_records()
+{
+    async_queue& q = queue();
+    std::array<std::string_view, 64> records;
+    while (true)
+    {
+        size_t position = q.tail.load(std::memory_order_relaxed);
+        size_t count    = 0;
+        while (count < records.size() && count < q.capacity)
+        {
+            async_slot& slot = q.slots[(position + count) % q.capacity];
+            if (slot.sequence.load(std::memory_order_acquire) != position + count + 1)
+                break;
+            if (slot.labels)
+                render_slot(slot);
+            records[count++] = slot.record;
+        }
+
+        if (count)
+        {
+            {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                current_sink()->write_all(records.data(), count);
+            }
+            for (size_t i = 0; i < count; i++)
+                q.slots[(position + i) % q.capacity].sequence.store(position + i + q.capacity, std::memory_order_release);
+            q.tail.store(position + count, std::memory_order_release);
+            continue;
+        }
+
+        if (size_t dropped = q.dropped.exchange(0, std::memory_order_relaxed))
+        {
+            const palette& colors = current_palette();
+            std::string record = colors.record_open + std::to_string(dropped) + colors.record_dropped;
+            std::lock_guard<std::mutex> lock(output_mutex);
+            current_sink()->write(record);
+        }
+        if (!q.running.load() && q.producers.load() == 0 && position == q.head.load(std::memory_order_acquire))
+            return;
+        {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            current_sink()->flush();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+
+// Binary Output
+DEBUG::trace_state::~trace_state()
+    { DEBUG::binary_trace(nullptr); }
+
+DEBUG::trace_state& DEBUG::trace()
+{
+    static trace_state t;
+    return t;
+}
+
+void DEBUG::write_frame(std::FILE* _file, frame _frame, std::string_view _payload)
+{
+    char head[5] = {static_cast<char>(_frame)};
+    store_integer(head + 1, _payload.size(), 4);
+    std::fwrite(head, 1, sizeof(head), _file);
+    std::fwrite(_payload.data(), 1, _payload.size(), _file);
+}
+
+void DEBUG::store_integer(char* _first, uint64_t _value, size_t _bytes)
+{
+    for (size_t i = 0; i < _bytes; i++)
+        _first[i] = static_cast<char>(_value >> (8 * i));
+}
+
+uint64_t DEBUG::get_integer(const char*& _cursor, size_t _bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < _bytes; i++)
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(*_cursor++)) << (8 * i);
+    return value;
+}
+
+void DEBUG::write_trace()
+{
+    trace_state& t = trace();
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::FILE* file = t.file.load(std::memory_order_relaxed);
+    if (!file)
+        return;
+
+    auto [label, inserted] = t.labels.try_emplace(labels, t.labels.size());
+    if (inserted)
+    {
+        size_t record_size = output.size();
+        put_integer(label_count, 4);
+        for (size_t i = 0; i < label_count; i++)
+            put_integer(labels[i].size(), 4), output += labels[i];
+        write_frame(file, frame::labels, std::string_view(output).substr(record_size));
+        output.resize(record_size);
+    }
+    store_integer(output.data(), label->second, 4);
+    write_frame(file, frame::record, output);
+}
+
+void DEBUG::put_event(event _event)
+{
+    output += static_cast<char>(_event);
+}
+
+void DEBUG::put_integer(uint64_t _value, size_t _bytes)
+{
+    output.resize(output.size() + _bytes);
+    store_integer(output.data() + output.size() - _bytes, _value, _bytes);
+}
+#endif
+
+template <typename _Tp>
+void DEBUG::put_number(const _Tp& _item)
+{
+    // The flags of the stream are in the header, so the decoder formats raw numbers the way std::cout would have.
+    if constexpr (std::is_integral_v<_Tp> && sizeof(_Tp) <= sizeof(uint64_t))
+    {
+        if (raw_numbers)
+        {
+            put_event(std::is_signed_v<_Tp> ? event::integer : event::unsigned_integer);
+            output += static_cast<char>(sizeof(_Tp));
+            return put_integer(static_cast<uint64_t>(_item), sizeof(_Tp));
+        }
+    }
+    else if constexpr (std::is_floating_point_v<_Tp> && sizeof(_Tp) <= sizeof(double))
+    {
+        if (raw_numbers)
+        {
+            double value = _item;
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            put_event(event::floating);
+            return put_integer(bits, 8);
+        }
+    }
+    else if constexpr (std::is_same_v<_Tp, long double>)
+    {
+        if (raw_numbers)
+        {
+            put_event(event::long_floating);
+            output += static_cast<char>(sizeof(_item));
+            return void(output.append(reinterpret_cast<const char*>(&_item), sizeof(_item)));
+        }
+    }
+
+    size_t start = begin_text();
+    binary = false;
+    print_number(_item);
+    binary = true;
+    end_text(start);
+}
+
+template <typename _Tp>
+void DEBUG::put_numbers(const _Tp* _item, size_t _size)
+{
+    // A vector of numbers is stored as one block in the byte order of the machine.
+    put_event(event::numbers);
+    output += static_cast<char>(std::is_floating_point_v<_Tp> ? event::floating :
+                                std::is_signed_v<_Tp> ? event::integer : event::unsigned_integer);
+    output += static_cast<char>(sizeof(_Tp));
+    put_integer(_size, 8);
+    output.append(reinterpret_cast<const char*>(_item), _size * sizeof(_Tp));
+}
+
+#if DEBUG_DEFINITIONS
+size_t DEBUG::begin_text()
+{
+    put_event(event::text);
+    output.append(4, '\0');
+    return output.size();
+}
+
+void DEBUG::end_text(size_t _start)
+{
+    store_integer(output.data() + _start - 4, output.size() - _start, 4);
+}
+
+void DEBUG::put_header()
+{
+    put_integer(0, 4);
+    output += static_cast<char>(hide_label | force_horizontal << 1);
+    put_integer(static_cast<uint32_t>(depth), 4);
+    put_integer(static_cast<uint32_t>(stream->flags()), 4);
+    put_integer(static_cast<uint32_t>(stream->precision()), 4);
+}
+
+bool DEBUG::available(const char* _cursor, const char* _last, size_t _bytes)
+{
+    return static_cast<size_t>(_last - _cursor) >= _bytes;
+}
+
+bool DEBUG::replay_record(const char* _cursor, const char* _last)
+{
+    output.swap(record_buffer());
+    bool valid = render_record(_cursor, _last);
+    if (valid)
+        write(output);
+    output.clear();
+    output.swap(record_buffer());
+    return valid;
+}
+
+bool DEBUG::render_record(const char* _cursor, const char* _last)
+{
+    if (!available(_cursor, _last, 29))
+        return false;
+    char flags         = *_cursor++;
+    hide_label         = flags & 1;
+    force_horizontal   = flags & 2;
+    depth              = static_cast<int32_t>(get_integer(_cursor, 4));
+    auto format_flags  = static_cast<std::ios_base::fmtflags>(get_integer(_cursor, 4));
+    auto precision     = static_cast<int32_t>(get_integer(_cursor, 4));
+    size_t thread      = get_integer(_cursor, 8);
+    size_t sequence    = get_integer(_cursor, 8);
+    if (depth < std::numeric_limits<int>::min() + static_cast<int>(MAX_REPLAY_NESTING) || precision > MAX_REPLAY_PRECISION)
+        return false;
+
+    colors        = &current_palette();
+    json          = colors == &json_palette;
+    depth        *= !json;
+    stream        = &format_stream();
+    stream_output = std::exchange(format_buffer().output, &output);
+    stream->flags(json ? std::ios_base::dec : format_flags);
+    stream->precision(precision);
+    stream->width(0);
+    if (stream->getloc() != std::locale::classic())
+        stream->imbue(std::locale::classic());
+    prepare_numbers();
+
+    // Nothing of a malformed record is printed.
+    bool valid = true;
+    print_record(thread, sequence);
+    for (bool separate = false; valid && _cursor != _last; separate = true)
+    {
+        if (separate)
+            output += (depth == 0 && !json) ? DEBUG_SEPARATOR : "\n";
+        print_label();
+        event first = static_cast<event>(*_cursor);
+        valid = replay(_cursor, _last);
+        print_type(first == event::integer || first == event::unsigned_integer || first == event::floating ||
+                   first == event::long_floating ? "number" : first == event::boolean ? "bool" : "string");
+    }
+    output += '\n';
+    format_buffer().output = stream_output;
+    return valid;
+}
+
+bool DEBUG::replay(const char*& _cursor, const char* _last)
+{
+    if (!available(_cursor, _last, 1) || nesting >= MAX_REPLAY_NESTING)
+        return false;
+
+    event current = static_cast<event>(*_cursor++);
+    if (current == event::integer || current == event::unsigned_integer)
+    {
+        // Integers are printed with their original size, which matters in hexadecimal and octal.
+        size_t bytes = available(_cursor, _last, 1) ? static_cast<unsigned char>(*_cursor++) : SIZE_MAX;
+        if (bytes > sizeof(uint64_t) || !available(_cursor, _last, bytes))
+            return false;
+        uint64_t value = get_integer(_cursor, bytes);
+        auto print_as  = [&](auto _type) { print_number(static_cast<decltype(_type)>(value)); };
+        if (current == event::integer)
+            bytes == 2 ? print_as(int16_t()) : bytes == 4 ? print_as(int32_t()) : print_as(int64_t());
+        else
+            bytes == 2 ? print_as(uint16_t()) : bytes == 4 ? print_as(uint32_t()) : print_as(uint64_t());
+    }
+    else if (current == event::floating)
+    {
+        if (!available(_cursor, _last, 8))
+            return false;
+        uint64_t bits = get_integer(_cursor, 8);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        print_number(value);
+    }
+    else if (current == event::long_floating)
+    {
+        long double value;
+        if (!available(_cursor, _last, 1 + sizeof(value)) || static_cast<size_t>(*_cursor) != sizeof(value))
+            return false;
+        std::memcpy(&value, _cursor + 1, sizeof(value));
+        _cursor += 1 + sizeof(value);
+        print_number(value);
+    }
+    else if (current == event::boolean)
+    {
+        if (!available(_cursor, _last, 1))
+            return false;
+        print_stream(*_cursor++ != 0);
+    }
+    else if (current == event::text || current == event::field)
+    {
+        if (!available(_cursor, _last, 4))
+            return false;
+        size_t size = get_integer(_cursor, 4);
+        if (!available(_cursor, _last, size))
+            return false;
+        std::string_view text(_cursor, size);
+        _cursor += size;
+        if (current == event::text)
+            print_text(text);
+        else
+            return print_field(text), replay(_cursor, _last);
+    }
+    else if (current == event::pointer || current == event::iterator)
+        return print_mark(current), replay(_cursor, _last);
+    else if (current == event::ellipsis)
+    {
+        if (!available(_cursor, _last, 8))
+            return false;
+        print_ellipsis(get_integer(_cursor, 8));
+    }
+    else if (current == event::removed)
+    {
+        output += colors->removed_open;
+        if (!replay(_cursor, _last))
+            return false;
+        output += colors->removed_close;
+    }
+    else if (current == event::open)
+    {
+        if (!available(_cursor, _last, 9) || static_cast<unsigned char>(*_cursor) > static_cast<unsigned char>(kind::range))
+            return false;
+        kind container = static_cast<kind>(*_cursor++);
+        get_integer(_cursor, 8);
+        print_open(container, 0);
+        for (bool separate = false; ; separate = true)
+        {
+            if (!available(_cursor, _last, 1))
+                return false;
+            if (static_cast<event>(*_cursor) == event::close)
+                break;
+            if (separate)
+                print_separator(container);
+            if (static_cast<event>(*_cursor) == event::numbers)
+            {
+                if (!replay_numbers(container, ++_cursor, _last))
+                    return false;
+                continue;
+            }
+            print_indent();
+            if (!replay(_cursor, _last))
+                return false;
+        }
+        ++_cursor;
+        print_close(container);
+    }
+    else
+        return false;
+    return true;
+}
+
+bool DEBUG::replay_numbers(kind _kind, const char*& _cursor, const char* _last)
+{
+    if (!available(_cursor, _last, 10))
+        return false;
+    event type   = static_cast<event>(*_cursor++);
+    size_t bytes = static_cast<unsigned char>(*_cursor++);
+    size_t count = get_integer(_cursor, 8);
+    if (bytes == 0 || count > static_cast<size_t>(_last - _cursor) / bytes)
+        return false;
+
+    // The block is copied out so that the numbers are aligned, and printed like the vector it came from.
+    auto print_as = [&](auto _type)
+    {
+        static thread_local std::vector<decltype(_type)> block;
+        block.resize(count);
+        std::memcpy(block.data(), _cursor, count * bytes);
+        print_content_numbers(_kind, block.data(), count);
+        return true;
+    };
+    bool valid = false;
+    if (type == event::integer)
+        valid = bytes == 2 ? print_as(int16_t()) : bytes == 4 ? print_as(int32_t()) : bytes == 8 && print_as(int64_t());
+    else if (type == event::unsigned_integer)
+        valid = bytes == 2 ? print_as(uint16_t()) : bytes == 4 ? print_as(uint32_t()) : bytes == 8 && print_as(uint64_t());
+    else if (type == event::floating)
+        valid = bytes == 4 ? print_as(float()) : bytes == 8 && print_as(double());
+    _cursor += valid ? count * bytes : 0;
+    return valid;
+}
+
+void DEBUG::print_snapshot(const DEBUG_SNAPSHOT& _snapshot)
+{
+    DEBUG record;
+    record.labels      = _snapshot.labels;
+    record.label_count = _snapshot.label_count;
+    if (!trace().file.load(std::memory_order_acquire))
+        return void(record.replay_record(_snapshot.data.data() + 4, _snapshot.data.data() + _snapshot.data.size()));
+
+    record.output.swap(record_buffer());
+    record.output = _snapshot.data;
+    record.write_trace();
+    record.output.clear();
+    record.output.swap(record_buffer());
+}
+
+
+// Main Control
+void DEBUG::print_delayed()
+{
+    // With asynchronous output the record is only encoded here, and the background thread formats it. Watch
+    // mode and byte limits depend on the text, so those records are still formatted on the calling thread.
+    depth   *= !force_horizontal;
+    binary   = trace().file.load(std::memory_order_acquire) != nullptr;
+    deferred = !binary && !(mode & DEBUG_WATCH) && limit.bytes == SIZE_MAX &&
+               queue().running.load(std::memory_order_relaxed);
+    binary  |= deferred;
+    output.swap(record_buffer());
+    prepare_format();
+    if (suppressed)
+        write(colors->record_open + std::to_string(suppressed) + colors->record_suppressed);
+    std::unique_lock<std::recursive_mutex> watch_lock(watch_mutex, std::defer_lock);
+    if (mode & DEBUG_WATCH)
+        watch_lock.lock();
+    if (binary)
+        put_header();
+    print_record();
+    (this->*delayed_print)(items);
+    if ((mode & DEBUG_WATCH) && !changed)
+        output.clear();
+    else if (deferred)
+    {
+        // If the queue stopped in the meantime, the record is formatted here after all.
+        if (!queue_record(output, labels, label_count))
+        {
+            DEBUG record;
+            record.labels      = labels;
+            record.label_count = label_count;
+            record.replay_record(output.data() + 4, output.data() + output.size());
+        }
+    }
+    else if (binary)
+        write_trace();
+    else
+        write(output);
+    output.clear();
+    output.swap(record_buffer());
+    format_buffer().output = stream_output;
+}
+
+std::string& DEBUG::record_buffer()
+{
+    static thread_local std::string record;
+    return record;
+}
+
+DEBUG::output_buffer& DEBUG::format_buffer()
+{
+    static thread_local output_buffer buffer;
+    return buffer;
+}
+
+std::ostream& DEBUG::format_stream()
+{
+    static thread_local std::ostream stream(&format_buffer());
+    return stream;
+}
+
+size_t DEBUG::thread_id()
+{
+    static thread_local size_t id = thread_count++;
+    return id;
+}
+
+const DEBUG::format_state& DEBUG::cout_format()
+{
+    // std::cout is only read under output_mutex, which every write to the sink holds too. While another thread
+    // holds it, the last snapshot of this thread is used instead of waiting for the writer.
+    static thread_local format_state state;
+    std::unique_lock<std::mutex> lock(output_mutex, std::defer_lock);
+    if (!state.captured)
+        lock.lock();
+    else if (!lock.try_lock())
+        return state;
+
+    state.flags     = std::cout.flags();
+    state.precision = std::cout.precision();
+    state.width     = std::cout.width();
+    state.fill      = std::cout.fill();
+    state.locale    = std::cout.getloc();
+    state.captured  = true;
+    return state;
+}
+
+void DEBUG::prepare_format()
+{
+    // A deferred record is formatted later in the current style, so its numbers are encoded for that style.
+    colors        = &current_palette();
+    json          = !binary && colors == &json_palette;
+    bool json_format = colors == &json_palette && (!binary || deferred);
+    depth        *= !json_format;
+    stream        = &format_stream();
+    stream_output = std::exchange(format_buffer().output, &output);
+    const format_state& format = cout_format();
+    stream->flags(json_format ? std::ios_base::dec : format.flags);
+    stream->precision(format.precision);
+    stream->width(json_format ? 0 : format.width);
+    stream->fill(format.fill);
+
+    std::locale locale = json_format ? std::locale::classic() : format.locale;
+    if (stream->getloc() != locale)
+        stream->imbue(locale);
+    prepare_numbers();
+}
+
+void DEBUG::prepare_numbers()
+{
+    std::ios_base::fmtflags flags = stream->flags();
+    raw_numbers = stream->width() == 0 && stream->getloc() == std::locale::classic();
+    bool plain  = raw_numbers && !(flags & (std::ios_base::showpos | std::ios_base::showbase | std::ios_base::uppercase));
+
+    fast_integral = plain && (flags & std::ios_base::basefield) == std::ios_base::dec;
+    fast_floating = plain && !(flags & std::ios_base::showpoint);
+    floating_precision = stream->precision();
+    fast_floating &= floating_precision >= 0;
+    if ((flags & std::ios_base::floatfield) == std::ios_base::fixed)
+        floating_format = std::chars_format::fixed;
+    else if ((flags & std::ios_base::floatfield) == std::ios_base::scientific)
+        floating_format = std::chars_format::scientific;
+    else if (flags & std::ios_base::floatfield)
+        fast_floating = false;
+    else
+        floating_format = std::chars_format::general;
+}
+
+void DEBUG::print_record()
+{
+    if (!binary && !DEBUG_THREAD_ID && !DEBUG_SEQUENCE)
+        return;
+
+    size_t thread   = DEBUG_THREAD_ID ? thread_id() : SIZE_MAX;
+    size_t sequence = DEBUG_SEQUENCE ? record_count++ : SIZE_MAX;
+    if (binary)
+        return put_integer(thread, 8), put_integer(sequence, 8);
+    print_record(thread, sequence);
+}
+
+void DEBUG::print_record(size_t _thread, size_t _sequence)
+{
+    if (json)
+    {
+        record_thread   = _thread;
+        record_sequence = _sequence;
+        return;
+    }
+    if (_thread == SIZE_MAX && _sequence == SIZE_MAX)
+        return;
+
+    output += colors->record_open;
+    if (_thread != SIZE_MAX)
+        print_number(_thread);
+    if (_thread != SIZE_MAX && _sequence != SIZE_MAX)
+        output += RECORD_SEPARATOR;
+    if (_sequence != SIZE_MAX)
+        output += RECORD_SEQUENCE, print_number(_sequence);
+    output += colors->record_close;
+}
+
+void DEBUG::print_label()
+{
+    if (binary)
+        return;
+
+    size_t index = label_index++;
+    if (json)
+    {
+        output += JSON_OBJECT_OPEN;
+        if (!hide_label && index < label_count)
+        {
+            print_field("label"), print_text(labels[index]);
+            output += JSON_SEPARATOR;
+        }
+        if (record_thread != SIZE_MAX)
+            print_field("thread"), print_number(record_thread), output += JSON_SEPARATOR;
+        if (record_sequence != SIZE_MAX)
+            print_field("sequence"), print_number(record_sequence), output += JSON_SEPARATOR;
+        return print_field("value");
+    }
+    if (index >= (force_horizontal ? 1 : label_count))
+        return;
+
+    if (hide_label)
+    {
+        output += colors->heading;
+        return;
+    }
+
+    if (index == 0 || depth)
+        output += colors->heading;
+    output += colors->label_open;
+    for (size_t i = force_horizontal ? 0 : index; i < (force_horizontal ? label_count : index + 1); i++)
+    {
+        if (i != 0 && force_horizontal)
+            output += DEBUG_SEPARATOR;
+        output += labels[i];
+        output += colors->label_close;
+    }
+    output += colors->equal;
+}
+
+void DEBUG::print_type(std::string_view _fallback)
+{
+    if (!json)
+        return;
+    output += JSON_SEPARATOR;
+    print_field("type");
+    print_text(item_type.empty() ? _fallback : item_type);
+    output += JSON_OBJECT_CLOSE;
+    item_type = {};
+}
+#endif
+
+
+template <typename _Tp>
+constexpr std::string_view DEBUG::scalar_type()
+{
+    if constexpr (std::is_same_v<_Tp, bool>)
+        return "bool";
+    else if constexpr (is_number<_Tp>::value)
+        return "number";
+    else
+        return "string";
+}
+
+template <typename... _Tps>
+void DEBUG::print_items(const void* _items)
+{
+    std::apply(
+        [&](const auto&... _item) { print_output(_item...); },
+        *static_cast<const std::tuple<_Tps...>*>(_items)
+    );
+}
+
+template <typename _Tp>
+void DEBUG::print_item(const _Tp& _item)
+{
+    print_label();
+    if (!(mode & DEBUG_WATCH))
+        return print(_item), print_type(scalar_type<_Tp>());
+
+    watched = &watch_states()[{labels, item_index++}];
+    size_t start = output.size();
+    print(_item);
+    print_type(scalar_type<_Tp>());
+    if (!watched)
+        return;
+
+    uint64_t fingerprint = std::hash<std::string_view>()(std::string_view(output).substr(start));
+    changed |= !watched->seen || watched->fingerprint != fingerprint;
+    watched->fingerprint = fingerprint;
+    watched->seen = true;
+    watched = nullptr;
+}
+
+template <typename _Tp>
+void DEBUG::print_output(const _Tp& _item)
+{
+    print_item(_item);
+    if (!binary)
+        output += '\n';
+}
+
+template <typename _Tp, typename... _Tps>
+void DEBUG::print_output(const _Tp& _item, const _Tps&... _items)
+{
+    print_item(_item);
+    if (!binary)
+        output += (depth == 0 && !json) ? DEBUG_SEPARATOR : "\n";
+    print_output(_items...);
+}
+
+
+// Print Opening and Closing
+#if DEBUG_DEFINITIONS
+void DEBUG::print_open(kind _kind, size_t _size)
+{
+    --depth, ++nesting;
+    if (binary)
+        return put_event(event::open), output += static_cast<char>(_kind), put_integer(_size, 8);
+    if (json && item_type.empty())
+        item_type = kind_names[static_cast<size_t>(_kind)];
+    output += colors->containers[static_cast<size_t>(_kind)].open;
+}
+
+void DEBUG::print_close(kind _kind)
+{
+    --nesting;
+    print_indent();
+    if (binary)
+        put_event(event::close);
+    else
+        output += colors->containers[static_cast<size_t>(_kind)].close;
+    ++depth;
+}
+
+void DEBUG::print_indent()
+{
+    if (depth > 0 && !binary)
+        output += '\n', output += colors->unfold, output.append(2 * nesting, ' ');
+}
+
+void DEBUG::print_separator(kind _kind)
+{
+    if (!binary)
+        output += colors->containers[static_cast<size_t>(_kind)].separator;
+}
+
+void DEBUG::print_mark(event _event)
+{
+    if (binary)
+        return put_event(_event);
+    if (json && item_type.empty())
+        item_type = _event == event::pointer ? "pointer" : "iterator";
+    output += _event == event::pointer ? colors->pointer_mark : colors->iterator_mark;
+}
+
+void DEBUG::print_field(std::string_view _name)
+{
+    if (binary)
+        return put_event(event::field), put_integer(_name.size(), 4), void(output += _name);
+    output += colors->label_open;
+    if (json)
+        print_escaped(output, _name);
+    else
+        output += _name;
+    output += colors->label_close;
+    output += colors->equal;
+}
+
+void DEBUG::print_text(std::string_view _text)
+{
+    if (json)
+    {
+        output += JSON_QUOTE;
+        print_escaped(output, _text);
+        output += JSON_QUOTE;
+        return;
+    }
+    if (!binary)
+        return void(output += _text);
+    size_t start = begin_text();
+    output += _text;
+    end_text(start);
+}
+
+void DEBUG::print_escaped(std::string& _output, std::string_view _text)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+    auto plain = [](char _c) { return static_cast<unsigned char>(_c) >= 0x20 && _c != '"' && _c != '\\'; };
+
+    for (auto first = _text.begin(); first != _text.end(); )
+    {
+        auto last = std::find_if_not(first, _text.end(), plain);
+        _output.append(first, last);
+        if (last == _text.end())
+            break;
+        unsigned char c = *last;
+        if (c == '"' || c == '\\')
+            _output += '\\', _output += c;
+        else if (c == '\n')
+            _output += "\\n";
+        else if (c == '\t')
+            _output += "\\t";
+        else if (c == '\r')
+            _output += "\\r";
+        else
+            _output += "\\u00", _output += hex[c >> 4], _output += hex[c & 15];
+        first = last + 1;
+    }
+}
+
+void DEBUG::print_quoted(size_t _start)
+{
+    auto plain = [](char _c) { return static_cast<unsigned char>(_c) >= 0x20 && _c != '"' && _c != '\\'; };
+    auto first = std::find_if_not(output.begin() + _start, output.end(), plain);
+    if (first != output.end())
+    {
+        std::string text(first, output.end());
+        output.erase(first, output.end());
+        print_escaped(output, text);
+    }
+    output += JSON_QUOTE;
+}
+#endif
+
+
+// Print Different Container
+template <typename _Tp1, typename _Tp2>
+void DEBUG::print_content_pair(kind _kind, const std::pair<_Tp1, _Tp2>& _item)
+{
+    print_indent(), print(_item.first);
+    print_separator(_kind);
+    print_indent(), print(_item.second);
+}
+
+template <typename... _Tps>
+void DEBUG::print_content_tuple(kind _kind, const std::tuple<_Tps...>& _item)
+{
+    std::apply(
+        [&](auto&&... args)
+        {
+            int k = sizeof...(_Tps);
+            ((print_indent(), print(args), --k ? print_separator(_kind) : void()), ...);
+        },
+        _item
+    );  
+}
+
+template <typename _Tp> 
+void DEBUG::print_content_container(kind _kind, const _Tp& _item)
+{
+    print_content_range(_kind, _item.begin(), _item.end(), _item.size());
+}
+
+template <typename _Tp> 
+void DEBUG::print_content_reversed(kind _kind, const _Tp& _item)
+{
+    print_content_range(_kind, _item.rbegin(), _item.rend(), _item.size());
+}
+
+template <typename _Tp> 
+void DEBUG::print_content_heap(kind _kind, const _Tp& _item)
+{
+    const auto& container = adaptor<_Tp>::container(_item);
+    if (!(mode & DEBUG_SORTED))
+        return print_content_container(_kind, container);
+
+    const auto& compare = adaptor<_Tp>::compare(_item);
+    std::vector<const typename _Tp::value_type*> order;
+    order.reserve(container.size());
+    for (const auto& element : container)
+        order.push_back(&element);
+
+    auto popped_first = [&](auto _lhs, auto _rhs) { return compare(*_rhs, *_lhs); };
+    size_t shown = std::min(order.size(), limit.elements);
+    if (shown == order.size() || limit.sampling == DEBUG_STRIDE)
+        std::sort(order.begin(), order.end(), popped_first);
+    else
+    {
+        size_t head = sample_head(order.size(), true);
+        size_t tail = shown - head;
+        std::partial_sort(order.begin(), order.begin() + head, order.end(), popped_first);
+        if (tail)
+        {
+            std::nth_element(order.begin() + head, order.end() - tail, order.end(), popped_first);
+            std::sort(order.end() - tail, order.end(), popped_first);
+        }
+    }
+    print_content_range<true>(_kind, order.begin(), order.end(), order.size());
+}
+
+template <bool _Indirect, typename _Iterator>
+void DEBUG::print_content_range(kind _kind, _Iterator _first, _Iterator _last, size_t _size)
+{
+    using category = typename std::iterator_traits<_Iterator>::iterator_category;
+    constexpr bool random_access = std::is_base_of_v<std::random_access_iterator_tag, category>;
+    constexpr bool bidirectional = std::is_base_of_v<std::bidirectional_iterator_tag, category>;
+
+    bool separate = false;
+    auto print_next = [&]()
+    {
+        if (separate)
+            print_separator(_kind);
+        separate = true;
+        print_indent();
+    };
+
+    if (_size && nesting > limit.depth)
+        return print_next(), print_ellipsis(_size);
+
+    if (watched && nesting == 1)
+        return print_content_watch<_Indirect>(_kind, _first, _last, _size);
+
+    if constexpr (random_access)
+    {
+        if (use_parallel(_size))
+            return print_content_parallel(_size, [&](DEBUG& _worker, size_t _begin, size_t _end)
+            {
+                for (size_t i = _begin; i < _end; i++)
+                {
+                    if (i)
+                        _worker.print_separator(_kind);
+                    _worker.print_indent();
+                    if constexpr (_Indirect)
+                        _worker.print(*_first[i]);
+                    else
+                        _worker.print(_first[i]);
+                }
+            });
+    }
+
+    size_t shown  = std::min(_size, limit.elements);
+    size_t head   = sample_head(_size, bidirectional);
+    size_t tail   = shown - head;
+    size_t stride = 1;
+    if (shown && shown < _size && limit.sampling == DEBUG_STRIDE && random_access)
+        stride = _size / shown;
+
+    _Iterator it = _first;
+    for (size_t i = 0; i < head; i++)
+    {
+        if (output.size() >= limit.bytes)
+            return print_next(), print_ellipsis(_size - i);
+        print_next();
+        if constexpr (_Indirect)
+            print(**it);
+        else
+            print(*it);
+        if (i + 1 != head)
+            std::advance(it, stride);
+    }
+
+    if (shown < _size)
+        print_next(), print_ellipsis(_size - shown);
+
+    if constexpr (bidirectional)
+    {
+        it = std::prev(_last, tail);
+        for (size_t i = 0; i < tail; i++, ++it)
+        {
+            if (output.size() >= limit.bytes)
+                return print_next(), print_ellipsis(tail - i);
+            print_next();
+            if constexpr (_Indirect)
+                print(**it);
+            else
+                print(*it);
+        }
+    }
+}
+
+template <bool _Indirect, typename _Iterator>
+void DEBUG::print_content_watch(kind _kind, _Iterator _first, _Iterator _last, size_t _size)
+{
+    using value_type = typename std::iterator_traits<_Iterator>::value_type;
+    constexpr size_t CHUNK = watch_state::CHUNK;
+
+    watch_state& state = *std::exchange(watched, nullptr);
+    bool keyed = _kind != kind::vector && _kind != kind::deque && _kind != kind::stack &&
+                 _kind != kind::queue && _kind != kind::priority_queue;
+
+    size_t previous = keyed ? state.keys.size() : state.elements.size();
+    changed |= !state.seen || _size != previous;
+
+    // Changed and removed elements count against the limits like printed elements do; the rest join the ellipsis.
+    bool separate = false;
+    size_t shown  = 0;
+    size_t elided = 0;
+    auto print_next = [&]()
+    {
+        if (separate)
+            print_separator(_kind);
+        separate = true;
+        print_indent();
+    };
+    auto print_changed = [&](auto _print)
+    {
+        changed = true;
+        if (shown >= limit.elements || output.size() >= limit.bytes)
+            return void(elided++);
+        if (elided)
+            print_next(), print_ellipsis(elided), elided = 0;
+        print_next();
+        _print();
+        shown++;
+    };
+
+    // Numbers print the same as long as their value and the format do, so a chunk of them whose bytes did not
+    // change since the previous call is skipped without printing it.
+    uint64_t seed = reinterpret_cast<uintptr_t>(colors) ^ stream->flags() ^ (uint64_t(stream->precision()) << 32);
+    auto mix = [](uint64_t _hash, const value_type& _value)
+    {
+        unsigned char bytes[sizeof(value_type)];
+        std::memcpy(bytes, &_value, sizeof(bytes));
+        for (unsigned char byte : bytes)
+            _hash = (_hash ^ byte) * 0x100000001b3;
+        return _hash;
+    };
+
+    state.scratch_keys.clear();
+    _Iterator it = _first;
+    for (size_t index = 0; index < _size && it != _last; )
+    {
+        size_t end = std::min(index + CHUNK, _size);
+        if constexpr (!_Indirect && std::is_arithmetic_v<value_type>)
+            if (!keyed)
+            {
+                uint64_t hash = seed ^ (end - index);
+                _Iterator chunk = it;
+                for (size_t i = index; i < end; i++, ++chunk)
+                    hash = mix(hash, static_cast<value_type>(*chunk));
+
+                size_t position = index / CHUNK;
+                bool same = state.seen && end <= previous && position < state.chunks.size() && state.chunks[position] == hash;
+                if (position == state.chunks.size())
+                    state.chunks.push_back(hash);
+                else
+                    state.chunks[position] = hash;
+                if (same)
+                {
+                    elided += end - index;
+                    std::advance(it, end - index);
+                    index = end;
+                    continue;
+                }
+            }
+
+        for (; index < end && it != _last; index++, ++it)
+        {
+            size_t start = output.size();
+            if constexpr (_Indirect)
+                print(**it);
+            else
+                print(*it);
+
+            uint64_t fingerprint = std::hash<std::string_view>()(std::string_view(output).substr(start));
+            state.text.assign(output, start);
+            output.resize(start);
+
+            bool same = false;
+            if (keyed)
+            {
+                auto found = std::lower_bound(state.keys.begin(), state.keys.end(), std::make_pair(fingerprint, size_t(0)));
+                same = found != state.keys.end() && found->first == fingerprint;
+                state.scratch_keys.emplace_back(fingerprint, index);
+            }
+            else
+            {
+                same = index < previous && state.elements[index] == fingerprint;
+                if (index < state.elements.size())
+                    state.elements[index] = fingerprint;
+                else
+                    state.elements.push_back(fingerprint);
+            }
+
+            if (same && state.seen)
+                elided++;
+            else
+                print_changed([&]() { output += state.text; });
+        }
+    }
+
+    // Elements that are gone are listed at the end by their previous position, since only their fingerprints are
+    // kept: the values missing from a keyed container, counted with their multiplicity, and the positions past the
+    // new size of the others.
+    state.removed.clear();
+    if (keyed)
+    {
+        std::sort(state.scratch_keys.begin(), state.scratch_keys.end());
+
+        auto next = state.scratch_keys.begin();
+        for (const auto& [fingerprint, position] : state.keys)
+        {
+            while (next != state.scratch_keys.end() && next->first < fingerprint)
+                ++next;
+            if (next != state.scratch_keys.end() && next->first == fingerprint)
+                ++next;
+            else
+                state.removed.push_back(position);
+        }
+        std::sort(state.removed.begin(), state.removed.end());
+        state.keys.swap(state.scratch_keys);
+    }
+    else
+    {
+        for (size_t i = _size; i < previous; i++)
+            state.removed.push_back(i);
+        state.elements.resize(std::min(state.elements.size(), _size));
+        state.chunks.resize(std::min(state.chunks.size(), (_size + CHUNK - 1) / CHUNK));
+    }
+
+    for (size_t position : state.removed)
+        print_changed([&]() { print_removed(position); });
+    if (elided)
+        print_next(), print_ellipsis(elided);
+    state.seen = true;
+}
+
+#if DEBUG_DEFINITIONS
+std::map<std::pair<const std::string_view*, size_t>, DEBUG::watch_state>& DEBUG::watch_states()
+{
+    static std::map<std::pair<const std::string_view*, size_t>, watch_state> states;
+    return states;
+}
+
+bool DEBUG::use_parallel(size_t _size)
+{
+    return _size >= DEBUG_PARALLEL_THRESHOLD && !parallel_worker && _size <= limit.elements &&
+           limit.bytes == SIZE_MAX && stream->width() == 0 && std::thread::hardware_concurrency() > 1;
+}
+
+void DEBUG::prepare_worker(const DEBUG& _parent)
+{
+    mode               = _parent.mode;
+    limit              = _parent.limit;
+    depth              = _parent.depth;
+    nesting            = _parent.nesting;
+    binary             = _parent.binary;
+    json               = _parent.json;
+    raw_numbers        = _parent.raw_numbers;
+    fast_integral      = _parent.fast_integral;
+    fast_floating      = _parent.fast_floating;
+    floating_format    = _parent.floating_format;
+    floating_precision = _parent.floating_precision;
+    parallel_worker    = true;
+    colors             = _parent.colors;
+
+    stream        = &format_stream();
+    stream_output = std::exchange(format_buffer().output, &output);
+    stream->flags(_parent.stream->flags());
+    stream->precision(_parent.stream->precision());
+    stream->fill(_parent.stream->fill());
+    if (stream->getloc() != _parent.stream->getloc())
+        stream->imbue(_parent.stream->getloc());
+}
+#endif
+
+template <typename _Render>
+void DEBUG::print_content_parallel(size_t _size, const _Render& _render)
+{
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t chunk   = std::max<size_t>(_size / (threads * 8), 1024);
+    std::vector<std::string> chunks((_size + chunk - 1) / chunk);
+    std::atomic<size_t> next{0};
+
+    auto work = [&]()
+    {
+        DEBUG worker;
+        worker.prepare_worker(*this);
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size(); )
+        {
+            _render(worker, i * chunk, std::min(_size, (i + 1) * chunk));
+            chunks[i].swap(worker.output);
+        }
+        format_buffer().output = worker.stream_output;
+    };
+
+    std::vector<std::thread> pool;
+    for (size_t i = 0; i < std::min(threads, chunks.size()); i++)
+        pool.emplace_back(work);
+    for (std::thread& thread : pool)
+        thread.join();
+
+    size_t total = output.size();
+    for (const std::string& text : chunks)
+        total += text.size();
+    output.reserve(total);
+    for (const std::string& text : chunks)
+        output += text;
+}
+
+#if DEBUG_DEFINITIONS
+size_t DEBUG::sample_head(size_t _size, bool _bidirectional)
+{
+    size_t shown = std::min(_size, limit.elements);
+    if (shown < _size && limit.sampling == DEBUG_HEAD_TAIL && _bidirectional)
+        return (shown + 1) / 2;
+    return shown;
+}
+
+void DEBUG::print_ellipsis(size_t _count)
+{
+    if (binary)
+        return put_event(event::ellipsis), put_integer(_count, 8);
+    output += colors->ellipsis_open;
+    print_number(_count);
+    output += colors->ellipsis_close;
+}
+
+void DEBUG::print_removed(size_t _position)
+{
+    if (binary)
+        return put_event(event::removed), print_number(_position);
+    output += colors->removed_open;
+    print_number(_position);
+    output += colors->removed_close;
+}
+#endif
+
+template <typename _Tp>
+void DEBUG::print_content_numbers(kind _kind, const _Tp* _item, size_t _size)
+{
+    if constexpr (sizeof(_Tp) <= sizeof(uint64_t))
+        if (binary && raw_numbers && !watched && _size <= limit.elements && nesting <= limit.depth && limit.bytes == SIZE_MAX)
+            return put_numbers(_item, _size);
+
+    size_t width = binary ? 0 : number_width<_Tp>();
+    if (!width || watched || _size > limit.elements || nesting > limit.depth || limit.bytes != SIZE_MAX)
+        return print_content_range(_kind, _item, _item + _size, _size);
+
+    if (use_parallel(_size))
+        return print_content_parallel(_size, [&](DEBUG& _worker, size_t _begin, size_t _end)
+        {
+            if (_begin)
+                _worker.print_separator(_kind);
+            _worker.print_content_numbers(_kind, _item + _begin, _end - _begin);
+        });
+
+    const std::string& separator = colors->containers[static_cast<size_t>(_kind)].separator;
+    size_t block = width + separator.size() + indent_size();
+    size_t start = output.size();
+    output.resize(start + block * _size);
+
+    char* first = output.data() + start;
+    char* last  = output.data() + output.size();
+    for (size_t i = 0; i < _size; i++)
+    {
+        first = print_indent(first);
+        first = format_number(first, last, _item[i]);
+        if (i + 1 != _size)
+            first = static_cast<char*>(std::memcpy(first, separator.data(), separator.size())) + separator.size();
+    }
+    output.resize(first - output.data());
+}
+
+template <typename _Labels, typename... _Tps>
+void DEBUG::print_content_fields(const _Labels& _names, const std::tuple<_Tps...>& _item)
+{
+    std::apply(
+        [&](const auto&... _field)
+        {
+            size_t index = 0;
+            ((print_indent(), print_field(_names[index]), print(_field),
+              ++index < sizeof...(_Tps) ? print_separator(kind::structure) : void()), ...);
+        },
+        _item
+    );
+}
+
+template <typename _Tp>
+auto DEBUG::fields(const _Tp& _item)
+{
+    if constexpr (has_member_fields<_Tp>::value)
+        return _item.tle_debug_fields();
+    else
+        return tle_debug_fields(_item);
+}
+
+template <typename _Alloc>
+void DEBUG::print_content_bits(kind _kind, const std::vector<bool, _Alloc>& _item)
+{
+    // Only plain 0 and 1 are written here; boolalpha, showbase and showpos go through operator<< as before.
+    std::ios_base::fmtflags flags = std::ios_base::boolalpha | std::ios_base::showbase | std::ios_base::showpos;
+    if (binary || json || watched || stream->width() || (stream->flags() & flags) ||
+        _item.size() > limit.elements || nesting > limit.depth || limit.bytes != SIZE_MAX)
+        return print_content_container(_kind, _item);
+
+    const std::string& separator = colors->containers[static_cast<size_t>(_kind)].separator;
+    size_t block = 1 + separator.size() + indent_size();
+    size_t start = output.size();
+    output.resize(start + block * _item.size());
+
+    char* first = output.data() + start;
+    auto print_bit = [&](char* _first, bool _bit)
+    {
+        _first    = print_indent(_first);
+        *_first++ = _bit ? '1' : '0';
+        return static_cast<char*>(std::memcpy(_first, separator.data(), separator.size())) + separator.size();
+    };
+#if defined(__GLIBCXX__) && !defined(_GLIBCXX_DEBUG)
+    // libstdc++ packs the bits into words of std::_Bit_type, lowest bit first, so a whole word is loaded at once.
+    const std::_Bit_type* words = _item.begin()._M_p;
+    for (size_t i = 0; i < _item.size(); i += std::_S_word_bit)
+    {
+        std::_Bit_type word = words[i / std::_S_word_bit];
+        size_t count        = std::min<size_t>(std::_S_word_bit, _item.size() - i);
+        for (size_t j = 0; j < count; j++, word >>= 1)
+            first = print_bit(first, word & 1);
+    }
+#else
+    for (bool bit : _item)
+        first = print_bit(first, bit);
+#endif
+    output.resize(first - output.data() - (_item.empty() ? 0 : separator.size()));
+}
+
+template <typename _Tp>
+template <typename _Pack>
+auto DEBUG::summary<_Tp>::lane(const _Pack& _pack, size_t _index)
+{
+    if constexpr (std::is_arithmetic_v<_Pack>)
+        return _pack;
+    else
+        return _pack[_index];
+}
+
+template <typename _Tp>
+typename DEBUG::summary<_Tp>::pack DEBUG::summary<_Tp>::load(const _Tp* _first, size_t _size)
+{
+    pack value;
+    if (_size >= WIDTH)
+        return std::memcpy(&value, _first, sizeof(value)), value;
+
+    // Pad the last vector with infinities, which are neither kept nor counted.
+    value = pack() + std::numeric_limits<_Tp>::infinity();
+    std::memcpy(&value, _first, _size * sizeof(_Tp));
+    return value;
+}
+
+template <typename _Tp>
+typename DEBUG::summary<_Tp>::mask DEBUG::summary<_Tp>::finite(const pack& _value)
+{
+    if constexpr (std::is_floating_point_v<_Tp>)
+        return (_value <= pack() + std::numeric_limits<_Tp>::max()) & (_value >= pack() - std::numeric_limits<_Tp>::max());
+    else
+        return true;
+}
+
+template <typename _Tp>
+void DEBUG::summary<_Tp>::tally(counter& _counter, const mask& _mask)
+{
+    // Vector comparisons give -1 for true.
+    if constexpr (vectorized)
+        _counter -= _mask;
+    else
+        _counter += _mask;
+}
+
+template <typename _Tp>
+void DEBUG::summary<_Tp>::reduce(const _Tp* _first, size_t _size)
+{
+    pack low  = pack() + min;
+    pack high = pack() + max;
+    for (size_t i = 0; i < _size; )
+    {
+        // Vector lanes are flushed every block, before their counters or float sums drift.
+        lane_sum total{};
+        counter finites{};
+        counter nans{};
+        for (size_t end = std::min(_size, i + BLOCK); i < end; i += WIDTH)
+        {
+            pack value = load(_first + i, _size - i);
+            mask keep  = finite(value);
+            low    = (keep & (value < low)) ? value : low;
+            high   = (keep & (value > high)) ? value : high;
+            total += keep ? value : pack();
+            tally(finites, keep);
+            tally(nans, value != value);
+        }
+        for (size_t j = 0; j < WIDTH; j++)
+        {
+            sum   += lane(total, j);
+            count += lane(finites, j);
+            nan   += lane(nans, j);
+        }
+    }
+
+    for (size_t j = 0; j < WIDTH; j++)
+    {
+        min = std::min<_Tp>(min, lane(low, j));
+        max = std::max<_Tp>(max, lane(high, j));
+    }
+    size += _size;
+}
+
+template <typename _Tp>
+void DEBUG::summary<_Tp>::spread(const _Tp* _first, size_t _size)
+{
+    if constexpr (std::is_integral_v<_Tp>)
+    {
+        // Integers are spread as doubles, which keeps this pass vectorized.
+        summary<double> doubles;
+        doubles.min   = static_cast<double>(min);
+        doubles.max   = static_cast<double>(max);
+        doubles.sum   = static_cast<double>(sum);
+        doubles.count = count;
+
+        double block[BLOCK];
+        for (size_t i = 0; i < _size; i += BLOCK)
+        {
+            size_t size = std::min(BLOCK, _size - i);
+            std::copy_n(_first + i, size, block);
+            doubles.spread(block, size);
+        }
+        squares += doubles.squares;
+        for (size_t k = 0; k < BINS; k++)
+            histogram[k] += doubles.histogram[k];
+        return;
+    }
+
+    using real_type = std::conditional_t<vectorized, _Tp, double>;
+    double scale = max > min ? BINS / (static_cast<double>(max) - static_cast<double>(min)) : 0;
+    real mean    = real() + static_cast<real_type>(static_cast<double>(sum) / count);
+    real low     = real() + static_cast<real_type>(min);
+    real factor  = real() + static_cast<real_type>(scale);
+    real last    = real() + static_cast<real_type>(BINS - 1);
+    real skip    = real() + static_cast<real_type>(BINS);
+
+    for (size_t i = 0; i < _size; )
+    {
+        // Each lane counts into its own bins; the extra bin collects values that are not kept.
+        real deviations{};
+        size_t bins[WIDTH][BINS + 1]{};
+        for (size_t end = std::min(_size, i + BLOCK); i < end; i += WIDTH)
+        {
+            pack value  = load(_first + i, _size - i);
+            mask keep   = finite(value);
+            real delta  = value - mean;
+            real bin    = (value - low) * factor;
+            deviations += keep ? delta * delta : real();
+            bin         = keep ? (bin < last ? bin : last) : skip;
+            for (size_t j = 0; j < WIDTH; j++)
+                bins[j][static_cast<size_t>(lane(bin, j))]++;
+        }
+        for (size_t j = 0; j < WIDTH; j++)
+        {
+            squares += lane(deviations, j);
+            for (size_t k = 0; k < BINS; k++)
+                histogram[k] += bins[j][k];
+        }
+    }
+}
+
+template <typename _Tp>
+bool DEBUG::print_summary(const _Tp& _item)
+{
+    using value_type = range_value<_Tp>;
+    if constexpr (!is_number<value_type>::value ||
+                  (std::is_integral_v<value_type> && sizeof(value_type) > sizeof(uint64_t)))
+        return false;
+    else
+    {
+        if (!(mode & DEBUG_SUMMARY))
+            return false;
+
+        summary<value_type> result;
+        auto run = [&](void (summary<value_type>::*_pass)(const value_type*, size_t))
+        {
+            if constexpr (is_contiguous<_Tp>::value)
+                (result.*_pass)(std::data(_item), range_size(_item));
+            else
+            {
+                value_type block[256];
+                size_t size = 0;
+                for (const value_type& element : _item)
+                {
+                    block[size++] = element;
+                    if (size == std::size(block))
+                        (result.*_pass)(block, size), size = 0;
+                }
+                if (size)
+                    (result.*_pass)(block, size);
+            }
+        };
+        run(&summary<value_type>::reduce);
+        if (result.count)
+            run(&summary<value_type>::spread);
+
+        auto print_fields = [&](const auto& _names, const auto& _fields)
+        {
+            print_open(kind::structure, _names.size());
+            print_content_fields(_names, _fields);
+            print_close(kind::structure);
+        };
+
+        int saved_mode = std::exchange(mode, mode & ~DEBUG_SUMMARY);
+        double mean    = static_cast<double>(result.sum) / result.count;
+        double stddev  = std::sqrt(result.squares / result.count);
+        if constexpr (std::is_floating_point_v<value_type>)
+        {
+            static constexpr std::array<std::string_view, 9> names{
+                "size", "min", "max", "sum", "mean", "stddev", "nan", "inf", "histogram"};
+            size_t inf = result.size - result.count - result.nan;
+            if (result.count)
+                print_fields(names, std::forward_as_tuple(result.size, result.min, result.max, result.sum,
+                                                          mean, stddev, result.nan, inf, result.histogram));
+            else
+                print_fields(std::array<std::string_view, 3>{names[0], names[6], names[7]},
+                             std::forward_as_tuple(result.size, result.nan, inf));
+        }
+        else
+        {
+            static constexpr std::array<std::string_view, 7> names{
+                "size", "min", "max", "sum", "mean", "stddev", "histogram"};
+            if (result.count)
+                print_fields(names, std::forward_as_tuple(result.size, result.min, result.max, result.sum,
+                                                          mean, stddev, result.histogram));
+            else
+                print_fields(std::array<std::string_view, 1>{names[0]}, std::forward_as_tuple(result.size));
+        }
+        mode = saved_mode;
+        return true;
+    }
 }
 
-
-// Main Control
-void DEBUG::generate_labels(std::string _label)
+template <typename _Tp>
+bool DEBUG::print_footprint(const _Tp& _item)
 {
-    int  indent_depth    = 0;
-    bool on_quote        = false;
-    bool on_double_quote = false;
-
-    labels.back() += LABEL_OPEN;
-    for (char& c : _label)
+    if constexpr (!is_range<_Tp>::value && !is_adaptor<_Tp>::value)
+        return false;
+    else
     {
-        if (c == ' ' && !on_quote && !on_double_quote)
-            continue;
+        if (!(mode & DEBUG_FOOTPRINT))
+            return false;
 
-        indent_depth    += c == '(' || c == '{' || c == '[' || c == '<';
-        indent_depth    -= c == ')' || c == '}' || c == ']' || c == '>';
-        on_quote        ^= c == '\'';
-        on_double_quote ^= c == '\"';
+        auto print_fields = [&](const auto& _names, const auto& _fields)
+        {
+            print_open(kind::structure, _names.size());
+            print_content_fields(_names, _fields);
+            print_close(kind::structure);
+        };
 
-        if (c == ',' && !indent_depth && !on_quote && !on_double_quote)
+        int saved_mode = std::exchange(mode, mode & ~DEBUG_FOOTPRINT);
+        size_t bytes   = heap_size(_item);
+        if constexpr (is_adaptor<_Tp>::value)
         {
-            labels.back() += LABEL_CLOSE;
-            if (force_horizontal)
-                labels.back() += DEBUG_SEPARATOR;
-            else
-                labels.push_back((depth ? DEBUG_HEADING : "") + LABEL_OPEN);
-            continue;
+            static constexpr std::array<std::string_view, 3> names{"size", "capacity", "bytes"};
+            const auto& container = adaptor<_Tp>::container(_item);
+            size_t capacity       = container.size();
+            if constexpr (has_capacity<std::remove_reference_t<decltype(container)>>::value)
+                capacity = container.capacity();
+            print_fields(names, std::forward_as_tuple(container.size(), capacity, bytes));
+        }
+        else if constexpr (has_capacity<_Tp>::value)
+        {
+            static constexpr std::array<std::string_view, 3> names{"size", "capacity", "bytes"};
+            print_fields(names, std::forward_as_tuple(_item.size(), _item.capacity(), bytes));
+        }
+        else if constexpr (has_buckets<_Tp>::value)
+        {
+            static constexpr std::array<std::string_view, 5> names{
+                "size", "buckets", "load_factor", "longest_chain", "bytes"};
+            size_t longest_chain = 0;
+            for (size_t i = 0; i < _item.bucket_count(); i++)
+                longest_chain = std::max(longest_chain, _item.bucket_size(i));
+            print_fields(names, std::forward_as_tuple(_item.size(), _item.bucket_count(), _item.load_factor(),
+                                                      longest_chain, bytes));
+        }
+        else if constexpr (std::is_same_v<typename std::iterator_traits<decltype(std::begin(_item))>::iterator_category,
+                                          std::bidirectional_iterator_tag>)
+        {
+            static constexpr std::array<std::string_view, 4> names{"size", "nodes", "node_bytes", "bytes"};
+            size_t size = range_size(_item);
+            print_fields(names, std::forward_as_tuple(size, size, size ? storage_size(_item) / size : 0, bytes));
+        }
+        else
+        {
+            static constexpr std::array<std::string_view, 2> names{"size", "bytes"};
+            print_fields(names, std::forward_as_tuple(range_size(_item), bytes));
         }
-        labels.back() += c;
+        mode = saved_mode;
+        return true;
     }
-    labels.back() += LABEL_CLOSE;
 }
 
+template <typename _Tp>
+constexpr size_t DEBUG::node_size(size_t _links)
+{
+    constexpr size_t align = std::max(alignof(_Tp), alignof(std::max_align_t));
+    return (_links * sizeof(void*) + sizeof(_Tp) + align - 1) / align * align;
+}
 
 template <typename _Tp>
-void DEBUG::print_output(const _Tp& _item)
+size_t DEBUG::storage_size(const _Tp& _item)
 {
-    if (!labels.empty())
+    if constexpr (has_capacity<_Tp>::value)
+        return _item.capacity() * sizeof(typename _Tp::value_type);
+    else if constexpr (has_buckets<_Tp>::value)
     {
-        if (hide_label)
-            std::cout << DEBUG_HEADING;
-        else
-            std::cout << labels.front() << DEBUG_EQUAL;
-        labels.pop_front();
+        // Each node holds a link, the element and possibly the cached hash. libstdc++ caches it unless the hash
+        // function is fast and cannot throw; other libraries are assumed to always cache it, as libc++ does.
+#ifdef __GLIBCXX__
+        constexpr bool cached = std::__cache_default<typename _Tp::key_type, typename _Tp::hasher>::value;
+#else
+        constexpr bool cached = true;
+#endif
+        return _item.bucket_count() * sizeof(void*) + _item.size() * node_size<typename _Tp::value_type>(1 + cached);
     }
-    print(_item);
-    std::cout << '\n';
+    else
+        return 0;
 }
 
-template <typename _Tp, typename... _Tps>
-void DEBUG::print_output(const _Tp& _item, const _Tps&... _items)
+template <typename _CharT, typename _Traits, typename _Alloc>
+size_t DEBUG::storage_size(const std::basic_string<_CharT, _Traits, _Alloc>& _item)
 {
-    if (!labels.empty())
-    {
-        if (hide_label)
-            std::cout << DEBUG_HEADING;
-        else
-            std::cout << labels.front() << DEBUG_EQUAL;
-        labels.pop_front();
-    }
-    print(_item);
-    std::cout << ((depth == 0) ? DEBUG_SEPARATOR : "\n");
-    print_output(_items...);
+    // Short strings are kept inside the object itself.
+    size_t local = std::basic_string<_CharT, _Traits, _Alloc>().capacity();
+    return _item.capacity() > local ? (_item.capacity() + 1) * sizeof(_CharT) : 0;
 }
 
+template <typename _Alloc>
+size_t DEBUG::storage_size(const std::vector<bool, _Alloc>& _item)
+{
+    return _item.capacity() / CHAR_BIT;
+}
 
-// Print Opening and Closing
-void DEBUG::print_open(const std::string& _label)
+template <typename _Tp, typename _Alloc>
+size_t DEBUG::storage_size(const std::deque<_Tp, _Alloc>& _item)
 {
-    --depth;
-    std::cout << _label;
-    indent += "  ";
+    // Elements live in 512-byte blocks, found through a map of at least 8 block pointers.
+    size_t block  = std::max(sizeof(_Tp), size_t(512)) / sizeof(_Tp) * sizeof(_Tp);
+    size_t blocks = _item.size() * sizeof(_Tp) / block + 1;
+    return blocks * block + std::max(blocks + 2, size_t(8)) * sizeof(void*);
 }
 
-void DEBUG::print_close(const std::string& _label)
+template <typename _Tp, typename _Alloc>
+size_t DEBUG::storage_size(const std::list<_Tp, _Alloc>& _item)
 {
-    indent.resize(indent.size() - 2);
-    std::cout << (depth <= 0 ? "" : "\n" + indent) << _label;
-    ++depth;
+    return _item.size() * node_size<_Tp>(2);
 }
 
+template <typename _Key, typename _Compare, typename _Alloc>
+size_t DEBUG::storage_size(const std::set<_Key, _Compare, _Alloc>& _item)
+{
+    return _item.size() * node_size<_Key>(4);
+}
 
-// Print Different Container
-template <typename _Tp1, typename _Tp2>
-void DEBUG::print_content_pair(const std::string& _label, const std::pair<_Tp1, _Tp2>& _item)
+template <typename _Key, typename _Compare, typename _Alloc>
+size_t DEBUG::storage_size(const std::multiset<_Key, _Compare, _Alloc>& _item)
 {
-    std::cout << (depth <= 0 ? "" : "\n" + indent), print(_item.first);
-    std::cout << _label;
-    std::cout << (depth <= 0 ? "" : "\n" + indent), print(_item.second);
+    return _item.size() * node_size<_Key>(4);
 }
 
-template <typename... _Tps>
-void DEBUG::print_content_tuple(const std::string& _label, const std::tuple<_Tps...>& _item)
+template <typename _Key, typename _Tp, typename _Compare, typename _Alloc>
+size_t DEBUG::storage_size(const std::map<_Key, _Tp, _Compare, _Alloc>& _item)
 {
-    std::apply(
-        [&](auto&&... args)
-        {
-            int k = sizeof...(_Tps);
-            ((std::cout << (depth <= 0 ? "" : "\n" + indent), print(args), std::cout << (--k ? _label : "")), ...);
-        },
-        _item
-    );  
+    return _item.size() * node_size<std::pair<const _Key, _Tp>>(4);
 }
 
-template <typename _Tp> 
-void DEBUG::print_content_container(const std::string& _label, const _Tp& _item)
+template <typename _Key, typename _Tp, typename _Compare, typename _Alloc>
+size_t DEBUG::storage_size(const std::multimap<_Key, _Tp, _Compare, _Alloc>& _item)
 {
-    for (auto it = _item.begin(); it != _item.end(); it++) {
-        std::cout << (depth <= 0 ? "" : "\n" + indent), print(*it);
-        if (next(it) != _item.end())
-            std::cout << _label;
-    }
+    return _item.size() * node_size<std::pair<const _Key, _Tp>>(4);
 }
 
-template <typename _Tp> 
-void DEBUG::print_content_query_front(const std::string& _label, const _Tp& _item)
+#ifdef DEBUG_PBDS
+template <typename _Key, typename _Tp, typename _Compare, typename _Tag, typename _Alloc>
+size_t DEBUG::storage_size(const __gnu_pbds::tree<_Key, _Tp, _Compare, _Tag, __gnu_pbds::tree_order_statistics_node_update, _Alloc>& _item)
+{
+    // Three links, the color and the subtree size.
+    return _item.size() * node_size<range_value<decltype(_item)>>(5);
+}
+#endif
+
+template <typename _Tp>
+size_t DEBUG::heap_size(const _Tp& _item)
 {
-    _Tp item = _item;
-    while (!item.empty())
+    if constexpr (std::is_trivially_copyable_v<_Tp>)
+        return 0;
+    else if constexpr (is_adaptor<_Tp>::value)
+        return heap_size(adaptor<_Tp>::container(_item));
+    else if constexpr (has_fields<_Tp>::value)
+        return std::apply([](const auto&... _field) { return (size_t(0) + ... + heap_size(_field)); }, fields(_item).second);
+    else if constexpr (is_range<_Tp>::value)
     {
-        std::cout << (depth <= 0 ? "" : "\n" + indent), print(item.front());
-        item.pop();
-        if (!item.empty())
-            std::cout << _label;
+        size_t bytes = storage_size(_item);
+        if constexpr (!std::is_trivially_copyable_v<range_value<_Tp>>)
+            for (const auto& element : _item)
+                bytes += heap_size(element);
+        return bytes;
     }
+    else
+        return 0;
 }
 
-template <typename _Tp> 
-void DEBUG::print_content_query_top(const std::string& _label, const _Tp& _item)
+template <typename _Tp1, typename _Tp2>
+size_t DEBUG::heap_size(const std::pair<_Tp1, _Tp2>& _item)
+{
+    return heap_size(_item.first) + heap_size(_item.second);
+}
+
+template <typename... _Tps>
+size_t DEBUG::heap_size(const std::tuple<_Tps...>& _item)
+{
+    return std::apply([](const auto&... _element) { return (size_t(0) + ... + heap_size(_element)); }, _item);
+}
+
+template <typename _Tp>
+size_t DEBUG::range_size(const _Tp& _item)
+{
+    if constexpr (has_size<_Tp>::value)
+        return std::size(_item);
+    else
+        return std::distance(std::begin(_item), std::end(_item));
+}
+
+#if DEBUG_DEFINITIONS
+size_t DEBUG::indent_size()
+{
+    return depth > 0 ? colors->unfold.size() + 2 * nesting + 1 : 0;
+}
+
+char* DEBUG::print_indent(char* _first)
+{
+    if (depth <= 0)
+        return _first;
+    *_first++ = '\n';
+    _first = static_cast<char*>(std::memcpy(_first, colors->unfold.data(), colors->unfold.size())) + colors->unfold.size();
+    return std::fill_n(_first, 2 * nesting, ' ');
+}
+#endif
+
+
+// Print Numbers
+template <typename _Tp>
+size_t DEBUG::number_width()
+{
+    if constexpr (std::is_integral_v<_Tp>)
+        return fast_integral ? std::numeric_limits<_Tp>::digits10 + 3 : 0;
+    else
+        return fast_floating && floating_format != std::chars_format::fixed ? floating_precision + 32 : 0;
+}
+
+template <typename _Tp>
+char* DEBUG::format_number(char* _first, char* _last, const _Tp& _item)
+{
+    std::to_chars_result result;
+    if constexpr (std::is_integral_v<_Tp>)
+        result = std::to_chars(_first, _last, _item);
+    else if (json && !std::isfinite(_item))
+        return std::copy(JSON_NULL.begin(), JSON_NULL.end(), _first);
+    else
+        result = std::to_chars(_first, _last, _item, floating_format, floating_precision);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+template <typename _Tp>
+void DEBUG::print_number(const _Tp& _item)
 {
-    _Tp item = _item;
-    while (!item.empty())
+    if (binary)
+        return put_number(_item);
+    if constexpr (std::is_floating_point_v<_Tp>)
+        if (json && !std::isfinite(_item))
+            return void(output += JSON_NULL);
+    if (std::is_integral_v<_Tp> ? fast_integral : fast_floating)
     {
-        std::cout << (depth <= 0 ? "" : "\n" + indent), print(item.top());
-        item.pop();
-        if (!item.empty())
-            std::cout << _label;
+        char digits[128];
+        char* last = format_number(digits, digits + sizeof(digits), _item);
+        if (last)
+            return void(output.append(digits, last));
     }
+    *stream << _item;
 }
 
 
 // Print Various Data Types
 template <typename _Tp>
-void DEBUG::print(_Tp* _item)
+void DEBUG::print(_Tp* const& _item)
 {
     if constexpr (std::is_same_v<_Tp, char> || std::is_same_v<_Tp, const char>)
-        std::cout << _item;
+        print_text(_item);
     else
-        std::cout << POINTER_MARK, print(*_item);
+        print_mark(event::pointer), print(*_item);
 }
 
 template <typename _Tp>
-void DEBUG::print(const _Tp* _item)
+void DEBUG::print(const _Tp* const& _item)
 {
     if constexpr (std::is_same_v<_Tp, char> || std::is_same_v<_Tp, const char>)
-        std::cout << _item;
+        print_text(_item);
     else
-        std::cout << POINTER_MARK, print(*_item);
+        print_mark(event::pointer), print(*_item);
 }
 
 template <typename _Tp>
 void DEBUG::print(const _Tp& _item)
 {
     if constexpr (is_iterator<_Tp>::value)
-        std::cout << ITERATOR_MARK, print(*_item);
+        print_mark(event::iterator), print(*_item);
+    else if constexpr (is_number<_Tp>::value)
+        print_number(_item);
+    else if constexpr (has_fields<_Tp>::value)
+    {
+        auto [names, values] = fields(_item);
+        print_open(kind::structure, std::tuple_size_v<decltype(values)>);
+        print_content_fields(*names, values);
+        print_close(kind::structure);
+    }
+    else if constexpr (is_range<_Tp>::value && !std::is_convertible_v<const _Tp&, std::string_view>)
+        print_range(_item);
+    else
+        print_stream(_item);
+}
+
+template <typename _Tp>
+void DEBUG::print_range(const _Tp& _item)
+{
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    size_t size = range_size(_item);
+    print_open(kind::range, size);
+    if constexpr (is_contiguous<_Tp>::value && is_number<range_value<_Tp>>::value)
+        print_content_numbers(kind::range, std::data(_item), size);
+    else
+        print_content_range(kind::range, std::begin(_item), std::end(_item), size);
+    print_close(kind::range);
+}
+
+template <typename _Tp, size_t _Nm>
+void DEBUG::print(const _Tp (&_item)[_Nm])
+{
+    if constexpr (std::is_same_v<_Tp, char>)
+        print(static_cast<const _Tp*>(_item));
     else
-        std::cout << _item;
+        print_range(_item);
+}
+
+template <typename _Tp>
+void DEBUG::print_stream(const _Tp& _item)
+{
+    if constexpr (std::is_same_v<_Tp, bool> || std::is_same_v<_Tp, std::vector<bool>::reference>)
+    {
+        if (json)
+            return void(output += _item ? "true" : "false");
+        if (binary)
+            return put_event(event::boolean), void(output += static_cast<char>(bool(_item)));
+        return void(*stream << bool(_item));
+    }
+    if (json)
+    {
+        output += JSON_QUOTE;
+        size_t start = output.size();
+        *stream << _item;
+        return print_quoted(start);
+    }
+    if (!binary)
+        return void(*stream << _item);
+    size_t start = begin_text();
+    *stream << _item;
+    end_text(start);
+}
+
+template <size_t _Nb>
+void DEBUG::print(const std::bitset<_Nb>& _item)
+{
+    if (stream->width())
+        return print_stream(_item);
+
+    if (json)
+        output += JSON_QUOTE;
+    size_t start = binary ? begin_text() : output.size();
+    output.append(_Nb, '0');
+#ifdef __GLIBCXX__
+    for (size_t i = _item._Find_first(); i < _Nb; i = _item._Find_next(i))
+        output[start + _Nb - 1 - i] = '1';
+#else
+    for (size_t i = 0; i < _Nb; i++)
+        output[start + _Nb - 1 - i] += _item[i];
+#endif
+    if (binary)
+        end_text(start);
+    if (json)
+        output += JSON_QUOTE;
 }
 
 template <typename _Tp1, typename _Tp2>
 void DEBUG::print(const std::pair<_Tp1, _Tp2>& _item)
 {
-    print_open(PAIR_OPEN);
-    print_content_pair(PAIR_SEPARATOR, _item);
-    print_close(PAIR_CLOSE);
+    print_open(kind::pair, 2);
+    print_content_pair(kind::pair, _item);
+    print_close(kind::pair);
 }
 
 template <typename... _Tps>
 void DEBUG::print(const std::tuple<_Tps...>& _item)
 {
-    print_open(TUPLE_OPEN);
-    print_content_tuple(TUPLE_SEPARATOR, _item);
-    print_close(TUPLE_CLOSE);
+    print_open(kind::tuple, sizeof...(_Tps));
+    print_content_tuple(kind::tuple, _item);
+    print_close(kind::tuple);
 }
 
 template <typename _Tp, typename ALLOCATOR>
 void DEBUG::print(const std::vector<_Tp, ALLOCATOR>& _item)
 {
-    print_open(VECTOR_OPEN);
-    print_content_container(VECTOR_SEPARATOR, _item);
-    print_close(VECTOR_CLOSE);
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    print_open(kind::vector, _item.size());
+    if constexpr (is_number<_Tp>::value)
+        print_content_numbers(kind::vector, _item.data(), _item.size());
+    else
+        print_content_container(kind::vector, _item);
+    print_close(kind::vector);
+}
+
+template <typename _Alloc>
+void DEBUG::print(const std::vector<bool, _Alloc>& _item)
+{
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::vector, _item.size());
+    print_content_bits(kind::vector, _item);
+    print_close(kind::vector);
 }
 
 template <typename _Key, typename _Compare, typename _Alloc>
 void DEBUG::print(const std::set<_Key, _Compare, _Alloc>& _item)
 {
-    print_open(SET_OPEN);
-    print_content_container(SET_SEPARATOR, _item);
-    print_close(SET_CLOSE);
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    print_open(kind::set, _item.size());
+    print_content_container(kind::set, _item);
+    print_close(kind::set);
 }
 
 template <typename _Key, typename _Compare, typename _Alloc>
 void DEBUG::print(const std::multiset<_Key, _Compare, _Alloc>& _item)
 {
-    print_open(MULTISET_OPEN);
-    print_content_container(MULTISET_SEPARATOR, _item);
-    print_close(MULTISET_CLOSE);
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    print_open(kind::multiset, _item.size());
+    print_content_container(kind::multiset, _item);
+    print_close(kind::multiset);
 }
 
 template <typename _Key, typename _Tp, typename _Compare, typename _Alloc>
 void DEBUG::print(const std::map<_Key, _Tp, _Compare, _Alloc>& _item)
 {
-    print_open(MAP_OPEN);
-    print_content_container(MAP_SEPARATOR, _item);
-    print_close(MAP_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::map, _item.size());
+    print_content_container(kind::map, _item);
+    print_close(kind::map);
 }
 
 template <typename _Key, typename _Tp, typename _Compare, typename _Alloc>
 void DEBUG::print(const std::multimap<_Key, _Tp, _Compare, _Alloc>& _item)
 {
-    print_open(MULTIMAP_OPEN);
-    print_content_container(MULTIMAP_SEPARATOR, _item);
-    print_close(MULTIMAP_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::multimap, _item.size());
+    print_content_container(kind::multimap, _item);
+    print_close(kind::multimap);
 }
 
 template <typename _Key, typename _Hash, typename _Pred, typename _Alloc>
 void DEBUG::print(const std::unordered_set<_Key, _Hash, _Pred, _Alloc>& _item)
 {
-    print_open(UNORDERED_SET_OPEN);
-    print_content_container(UNORDERED_SET_SEPARATOR, _item);
-    print_close(UNORDERED_SET_CLOSE);
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    print_open(kind::unordered_set, _item.size());
+    print_content_container(kind::unordered_set, _item);
+    print_close(kind::unordered_set);
 }
 
 template <typename _Key, typename _Hash, typename _Pred, typename _Alloc>
 void DEBUG::print(const std::unordered_multiset<_Key, _Hash, _Pred, _Alloc>& _item)
 {
-    print_open(UNORDERED_MULTISET_OPEN);
-    print_content_container(UNORDERED_MULTISET_SEPARATOR, _item);
-    print_close(UNORDERED_MULTISET_CLOSE);
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    print_open(kind::unordered_multiset, _item.size());
+    print_content_container(kind::unordered_multiset, _item);
+    print_close(kind::unordered_multiset);
 }
 
 template <typename _Key, typename _Tp, typename _Hash, typename _Pred, typename _Alloc>
 void DEBUG::print(const std::unordered_map<_Key, _Tp, _Hash, _Pred, _Alloc>& _item)
 {
-    print_open(UNORDERED_MAP_OPEN);
-    print_content_container(UNORDERED_MAP_SEPARATOR, _item);
-    print_close(UNORDERED_MAP_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::unordered_map, _item.size());
+    print_content_container(kind::unordered_map, _item);
+    print_close(kind::unordered_map);
 }
 
 template <typename _Key, typename _Tp, typename _Hash, typename _Pred, typename _Alloc>
 void DEBUG::print(const std::unordered_multimap<_Key, _Tp, _Hash, _Pred, _Alloc>& _item)
 {
-    print_open(UNORDERED_MULTIMAP_OPEN);
-    print_content_container(UNORDERED_MULTIMAP_SEPARATOR, _item);
-    print_close(UNORDERED_MULTIMAP_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::unordered_multimap, _item.size());
+    print_content_container(kind::unordered_multimap, _item);
+    print_close(kind::unordered_multimap);
 }
 
 template <typename _Tp, typename _Sequence>
 void DEBUG::print(const std::stack<_Tp, _Sequence>& _item)
 {
-    print_open(STACK_OPEN);
-    print_content_query_top(STACK_SEPARATOR, _item);
-    print_close(STACK_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::stack, _item.size());
+    print_content_reversed(kind::stack, adaptor<std::stack<_Tp, _Sequence>>::container(_item));
+    print_close(kind::stack);
 }
 
 template <typename _Tp, typename _Sequence>
 void DEBUG::print(const std::queue<_Tp, _Sequence>& _item)
 {
-    print_open(QUEUE_OPEN);
-    print_content_query_front(QUEUE_SEPARATOR, _item);
-    print_close(QUEUE_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::queue, _item.size());
+    print_content_container(kind::queue, adaptor<std::queue<_Tp, _Sequence>>::container(_item));
+    print_close(kind::queue);
 }
 
 template <typename _Tp, typename _Alloc>
 void DEBUG::print(const std::deque<_Tp, _Alloc>& _item)
 {
-    print_open(DEQUE_OPEN);
-    print_content_container(DEQUE_SEPARATOR, _item);
-    print_close(DEQUE_CLOSE);
+    if (print_footprint(_item) || print_summary(_item))
+        return;
+
+    print_open(kind::deque, _item.size());
+    print_content_container(kind::deque, _item);
+    print_close(kind::deque);
 }
 
 template <typename _Tp, typename _Sequence, typename _Compare>
 void DEBUG::print(const std::priority_queue<_Tp, _Sequence, _Compare>& _item)
 {
-    print_open(PRIORITY_QUEUE_OPEN);
-    print_content_query_top(PRIORITY_QUEUE_SEPARATOR, _item);
-    print_close(PRIORITY_QUEUE_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::priority_queue, _item.size());
+    print_content_heap(kind::priority_queue, _item);
+    print_close(kind::priority_queue);
 }
 
+#ifdef DEBUG_PBDS
 template <typename _Key, typename _Tp, typename _Compare, typename _Tag, typename _Alloc>
 void DEBUG::print(const __gnu_pbds::tree<_Key, _Tp, _Compare, _Tag, __gnu_pbds::tree_order_statistics_node_update, _Alloc>& _item)
 {
-    print_open(PRIORITY_QUEUE_OPEN);
-    print_content_container(PRIORITY_QUEUE_SEPARATOR, _item);
-    print_close(PRIORITY_QUEUE_CLOSE);
+    if (print_footprint(_item))
+        return;
+
+    print_open(kind::tree, _item.size());
+    print_content_container(kind::tree, _item);
+    print_close(kind::tree);
 }
+#endif
 
 
 // External Parameter
+#if DEBUG_DEFINITIONS
 DEBUG& DEBUG::operator() (const bool& _force_horizontal)
 {
     force_horizontal = _force_horizontal;
@@ -352,43 +2734,390 @@ DEBUG& DEBUG::operator() (const int& _unfold_depth)
     return *this;
 }
 
+DEBUG& DEBUG::operator() (const DEBUG_MODE& _mode)
+{
+    mode |= _mode;
+    return *this;
+}
+
+DEBUG& DEBUG::operator() (const DEBUG_LIMIT& _limit)
+{
+    limit = _limit;
+    return *this;
+}
+
 void DEBUG::operator-- (int _x)
 {
     hide_label = true;
 }
 
 
+// Snapshot
+DEBUG_SNAPSHOT DEBUG::snapshot()
+{
+    DEBUG_SNAPSHOT result;
+    if (!delayed_print)
+        return result;
+
+    depth *= !force_horizontal;
+    mode  &= ~DEBUG_WATCH;
+    binary = true;
+    output.swap(record_buffer());
+    prepare_format();
+    put_header();
+    print_record();
+    (this->*std::exchange(delayed_print, nullptr))(items);
+
+    result.labels      = labels;
+    result.label_count = label_count;
+    result.data        = output;
+    output.clear();
+    output.swap(record_buffer());
+    format_buffer().output = stream_output;
+    return result;
+}
+
+bool DEBUG_SNAPSHOT::empty() const
+    { return data.empty(); }
+
+size_t DEBUG_SNAPSHOT::size() const
+    { return data.size(); }
+
+void DEBUG_SNAPSHOT::print() const
+{
+    if (!data.empty())
+        DEBUG::print_snapshot(*this);
+}
+
+
 
 // Construector and Destructor
 LINE::LINE()
     {}
+#endif
 
 template <typename... _Tps>
 LINE::LINE(const _Tps&... _items)
-    : delayed_print([&, _items...]() { return print_output(_items...); })
+    : delayed_print([&, _items...]() { std::string record; print_output(record, _items...); })
     {}
 
+#if DEBUG_DEFINITIONS
 LINE::~LINE()
-    { delayed_print(); }   
+{
+    if (delayed_print)
+        delayed_print();
+}
 
 
 // Main Control
-void LINE::print_output() {}
+void LINE::print_output(std::string& _record)
+{
+    // All the lines of one call are written together, so that they are not split by other threads.
+    if (!_record.empty())
+        DEBUG::write(_record);
+}
+#endif
 
 template <typename... _Tps>
-void LINE::print_output(const std::string& _item, const _Tps&... _items)
+void LINE::print_output(std::string& _record, const std::string& _item, const _Tps&... _items)
 {
     std::string result;
     for (size_t i = 0; i < length; i++)
         result += _item[i % _item.size()];
-    std::cout << result << '\n';
-    print_output(_items...);
+    if (&DEBUG::current_palette() == &DEBUG::json_palette)
+    {
+        // JSON output stays one object per line, so the line is printed as an event that holds its text.
+        std::string text = std::exchange(result, JSON_LINE_OPEN);
+        DEBUG::print_escaped(result, text);
+        result += JSON_LINE_CLOSE;
+    }
+    result += '\n';
+    _record += result;
+    print_output(_record, _items...);
 }
 
 
 // External Parameter
+#if DEBUG_DEFINITIONS
 void LINE::operator() (const size_t& _length)
     { length = _length; }
 
 
+
+// Constructor
+PROBE::PROBE(std::string_view _name, type _kind)
+    : name(_name), kind(_kind)
+{
+    // Touch the output state first, so that it outlives the report at exit.
+    static const int registered = (DEBUG::flush(), origin(), std::atexit(exit_report));
+    (void)registered;
+
+    next = probes.load(std::memory_order_relaxed);
+    while (!probes.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+
+// Histogram
+size_t PROBE::bucket(uint64_t _value)
+{
+    if (_value < SUB_BUCKETS)
+        return _value;
+    size_t exponent = 63 - __builtin_clzll(_value);
+    return (exponent - SUB_BITS + 1) * SUB_BUCKETS + ((_value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+uint64_t PROBE::bucket_value(size_t _bucket)
+{
+    if (_bucket < SUB_BUCKETS)
+        return _bucket;
+    size_t exponent = _bucket / SUB_BUCKETS + SUB_BITS - 1;
+    return uint64_t(SUB_BUCKETS + _bucket % SUB_BUCKETS) << (exponent - SUB_BITS);
+}
+
+uint64_t PROBE::percentile(const uint64_t (&_histogram)[BUCKETS], uint64_t _samples, uint64_t _permille) const
+{
+    uint64_t rank = std::max<uint64_t>(1, (_samples * _permille + 999) / 1000);
+    size_t index = 0;
+    for (uint64_t seen = 0; index + 1 < BUCKETS && (seen += _histogram[index]) < rank; index++);
+
+    uint64_t low  = minimum.load(std::memory_order_relaxed);
+    uint64_t high = maximum.load(std::memory_order_relaxed);
+    return std::clamp(bucket_value(index), low, std::max(low, high));
+}
+
+
+// Clock
+const PROBE::clock_origin& PROBE::origin()
+{
+    static const clock_origin start{now(), std::chrono::steady_clock::now()};
+    return start;
+}
+
+double PROBE::tick_length()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    const clock_origin& start = origin();
+    auto elapsed = std::chrono::steady_clock::now() - start.time;
+    if (elapsed < std::chrono::milliseconds(10))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed);
+
+    auto time = std::chrono::steady_clock::now();
+    uint64_t ticks = now();
+    return std::chrono::duration<double, std::nano>(time - start.time).count() / (ticks - start.ticks);
+#else
+    return 1;
+#endif
+}
+
+
+// Report
+std::string PROBE::format_duration(double _nanoseconds)
+{
+    static constexpr std::pair<double, const char*> units[] = {{1e9, "s"}, {1e6, "ms"}, {1e3, "us"}, {1, "ns"}};
+
+    char buffer[32];
+    for (const auto& [scale, unit] : units)
+        if (_nanoseconds >= scale || scale == 1)
+            return std::string(buffer, std::snprintf(buffer, sizeof(buffer), "%.4g%s", _nanoseconds / scale, unit));
+    return std::string();
+}
+
+void PROBE::print_report(std::string& _output, double _tick_length) const
+{
+    uint64_t snapshot[BUCKETS];
+    uint64_t samples = 0;
+    for (size_t i = 0; i < BUCKETS; i++)
+        samples += snapshot[i] = histogram[i].load(std::memory_order_relaxed);
+    if (samples == 0)
+        return;
+
+    const DEBUG::palette& colors = DEBUG::current_palette();
+    bool json = &colors == &DEBUG::json_palette;
+
+    // JSON reports durations as a number of nanoseconds.
+    auto value = [&](uint64_t _value)
+    {
+        if (kind == type::counter)
+            return std::to_string(_value);
+        if (!json)
+            return format_duration(_value * _tick_length);
+        char digits[32];
+        return std::string(digits, std::to_chars(digits, digits + sizeof(digits), _value * _tick_length).ptr);
+    };
+
+    const std::pair<std::string_view, std::string> fields[] = {
+        {"count", std::to_string(samples)},
+        {"total", value(total.load(std::memory_order_relaxed))},
+        {"min",   value(minimum.load(std::memory_order_relaxed))},
+        {"p50",   value(percentile(snapshot, samples, 500))},
+        {"p99",   value(percentile(snapshot, samples, 990))},
+        {"max",   value(maximum.load(std::memory_order_relaxed))}
+    };
+
+    const DEBUG::token_set& tokens = colors.containers[static_cast<size_t>(DEBUG::kind::structure)];
+    if (json)
+    {
+        _output += JSON_OBJECT_OPEN + JSON_QUOTE + "label" + JSON_QUOTE + JSON_EQUAL + JSON_QUOTE;
+        DEBUG::print_escaped(_output, name);
+        _output += JSON_QUOTE + JSON_SEPARATOR + JSON_QUOTE + "value" + JSON_QUOTE + JSON_EQUAL;
+    }
+    else
+    {
+        _output += colors.heading;
+        _output += colors.label_open;
+        _output += name;
+        _output += colors.label_close;
+        _output += colors.equal;
+    }
+    _output += tokens.open;
+    for (const auto& [field, text] : fields)
+    {
+        if (&field != &fields[0].first)
+            _output += tokens.separator;
+        _output += colors.label_open;
+        _output += field;
+        _output += colors.label_close;
+        _output += colors.equal;
+        _output += text;
+    }
+    _output += tokens.close;
+    if (json)
+        _output += JSON_SEPARATOR + JSON_QUOTE + "type" + JSON_QUOTE + JSON_EQUAL + JSON_QUOTE +
+                   (kind == type::timer ? "timer" : "counter") + JSON_QUOTE + JSON_OBJECT_CLOSE;
+    _output += '\n';
+}
+
+void PROBE::exit_report()
+{
+    if (DEBUG_PROBE_REPORT)
+        report();
+}
+
+
+// Main Control
+uint64_t PROBE::now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void PROBE::add(uint64_t _value)
+{
+    total.fetch_add(_value, std::memory_order_relaxed);
+    histogram[bucket(_value)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t current = minimum.load(std::memory_order_relaxed);
+    while (_value < current && !minimum.compare_exchange_weak(current, _value, std::memory_order_relaxed));
+    current = maximum.load(std::memory_order_relaxed);
+    while (_value > current && !maximum.compare_exchange_weak(current, _value, std::memory_order_relaxed));
+}
+
+void PROBE::report()
+{
+    std::vector<const PROBE*> sites;
+    bool timed = false;
+    for (const PROBE* probe = probes.load(std::memory_order_acquire); probe; probe = probe->next)
+        sites.push_back(probe), timed |= probe->kind == type::timer;
+
+    double length = timed ? tick_length() : 1;
+    std::string output;
+    for (auto site = sites.rbegin(); site != sites.rend(); site++)
+        (*site)->print_report(output, length);
+    if (!output.empty())
+        DEBUG::write(output);
+}
+
+
+
+// Constructor and Destructor
+TIMER::TIMER(PROBE* _probe)
+    : probe(_probe)
+{
+    if (probe)
+        start = PROBE::now();
+}
+
+TIMER::~TIMER()
+{
+    if (probe)
+        probe->add(PROBE::now() - start);
+}
+
+
+
+// Main Control
+int64_t THROTTLE::now()
+{
+#if defined(DEBUG_POSIX) && defined(CLOCK_MONOTONIC_COARSE)
+    // Buckets refill over a second, so the millisecond resolution of the coarse clock is enough.
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+    return time.tv_sec * int64_t(1000000000) + time.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint64_t THROTTLE::pass(DEBUG_RATE _rate, uint64_t _count)
+{
+    if (_rate == DEBUG_EVERY)
+        return calls.fetch_add(1, std::memory_order_relaxed) % std::max<uint64_t>(_count, 1) == 0;
+
+    if (_rate == DEBUG_FIRST)
+        return calls.load(std::memory_order_relaxed) < _count &&
+               calls.fetch_add(1, std::memory_order_relaxed) < _count;
+
+    // A token bucket of one second, kept as the time its next token is due.
+    if (_count == 0)
+        return 0;
+    constexpr int64_t second = 1000000000;
+    int64_t interval = second / static_cast<int64_t>(std::min<uint64_t>(_count, second));
+    int64_t time = now();
+
+    int64_t due = next.load(std::memory_order_relaxed);
+    int64_t start;
+    do
+    {
+        start = std::max(due, time);
+        if (start - time > second - interval)
+            return suppressed.fetch_add(1, std::memory_order_relaxed), 0;
+    }
+    while (!next.compare_exchange_weak(due, start + interval, std::memory_order_relaxed));
+    return 1 + suppressed.exchange(0, std::memory_order_relaxed);
+}
+#endif
+
+
+// Explicit Instantiation
+#define DEBUG_INSTANTIATE(_declare)                                                                      \
+    _declare void DEBUG::print_number(const int&);                                                       \
+    _declare void DEBUG::print_number(const long long&);                                                 \
+    _declare void DEBUG::print_number(const double&);                                                    \
+    _declare void DEBUG::print(const std::string&);                                                      \
+    _declare void DEBUG::print(const std::pair<int, int>&);                                              \
+    _declare void DEBUG::print(const std::vector<int>&);                                                 \
+    _declare void DEBUG::print(const std::vector<long long>&);                                           \
+    _declare void DEBUG::print(const std::vector<double>&);                                              \
+    _declare void DEBUG::print(const std::vector<std::string>&);                                         \
+    _declare void DEBUG::print(const std::vector<std::pair<int, int>>&);                                 \
+    _declare void DEBUG::print(const std::vector<std::vector<int>>&);                                    \
+    _declare void DEBUG::print(const std::vector<std::vector<long long>>&);                              \
+    _declare void DEBUG::print(const std::set<int>&);                                                    \
+    _declare void DEBUG::print(const std::set<long long>&);                                              \
+    _declare void DEBUG::print(const std::map<int, int>&);                                               \
+    _declare void DEBUG::print(const std::map<long long, long long>&);                                   \
+    _declare void DEBUG::print(const std::unordered_map<int, int>&);
+
+#if defined(DEBUG_LIBRARY) && defined(DEBUG_LIBRARY_SOURCE)
+DEBUG_INSTANTIATE(template)
+#elif defined(DEBUG_LIBRARY)
+DEBUG_INSTANTIATE(extern template)
+#endif
+
+
 #endif /* _TLE_DEBUG_CPP */
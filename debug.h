@@ -26,20 +26,81 @@
 
 
 #include <iostream>
+#include <algorithm>
 #include <functional>
+#include <utility>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <array>
+#include <tuple>
 #include <vector>
+#include <list>
 #include <set>
 #include <map>
 #include <unordered_set>
 #include <unordered_map>
 #include <stack>
 #include <queue>
+#include <bitset>
+
+#ifndef DEBUG_NO_PBDS
+#define DEBUG_PBDS 1
 #include <ext/pb_ds/assoc_container.hpp>
 #include <ext/pb_ds/tree_policy.hpp>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DEBUG_POSIX 1
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <time.h>
+#endif
+
+#if defined(DEBUG_LIBRARY) && !defined(DEBUG_LIBRARY_SOURCE)
+#define DEBUG_DEFINITIONS 0
+#else
+#define DEBUG_DEFINITIONS 1
+#endif
+
+#if defined(__GNUC__) && defined(__AVX__)
+#define DEBUG_VECTOR_BYTES 32
+#elif defined(__GNUC__)
+#define DEBUG_VECTOR_BYTES 16
+#else
+#define DEBUG_VECTOR_BYTES 0
+#endif
+
+
+inline size_t LINE_LENGTH = 50;
 
+inline bool DEBUG_THREAD_ID = false;
+inline bool DEBUG_SEQUENCE  = false;
 
-size_t LINE_LENGTH = 50;
+inline size_t DEBUG_PARALLEL_THRESHOLD = 1 << 16;
+
+inline bool DEBUG_PROBE_REPORT = true;
+
+
+#ifndef DEBUG_MIN_LEVEL
+#define DEBUG_MIN_LEVEL DEBUG_TRACE
+#endif
 
 
 const std::string DEBUG_HEADING                = "\x1B[92m> \033[0m";
@@ -47,6 +108,13 @@ const std::string DEBUG_SEPARATOR              = ", ";
 const std::string DEBUG_EQUAL                  = "\x1B[33m = \033[0m";
 const std::string DEBUG_UNFOLD                 = "\x1B[96m|\033[0m";
 
+const std::string RECORD_OPEN                  = "\x1B[90m[";
+const std::string RECORD_SEPARATOR             = " ";
+const std::string RECORD_SEQUENCE              = "#";
+const std::string RECORD_CLOSE                 = "]\033[0m ";
+const std::string RECORD_DROPPED               = " records dropped]\033[0m\n";
+const std::string RECORD_SUPPRESSED            = " calls suppressed]\033[0m\n";
+
 const std::string LABEL_OPEN                   = "\033[3m";
 const std::string LABEL_SEPARATOR              = ",";
 const std::string LABEL_CLOSE                  = "\033[0m";
@@ -117,32 +185,692 @@ const std::string PRIORITY_QUEUE_OPEN          = "\x1B[31m{\033[0m";
 const std::string PRIORITY_QUEUE_SEPARATOR     = " ";
 const std::string PRIORITY_QUEUE_CLOSE         = "\x1B[31m}\033[0m";
 
+const std::string RANGE_OPEN                   = "\x1B[35m[\033[0m";
+const std::string RANGE_SEPARATOR              = " ";
+const std::string RANGE_CLOSE                  = "\x1B[35m]\033[0m";
+
+const std::string STRUCT_OPEN                  = "\x1B[94m{\033[0m";
+const std::string STRUCT_SEPARATOR             = ", ";
+const std::string STRUCT_CLOSE                 = "\x1B[94m}\033[0m";
+
+const std::string ELLIPSIS_OPEN                = "\x1B[90m\u2026 (";
+const std::string ELLIPSIS_CLOSE               = " more)\033[0m";
+
+const std::string REMOVED_OPEN                 = "\x1B[31m-#";
+const std::string REMOVED_CLOSE                = "\033[0m";
+
+const std::string TRACE_MAGIC                  = "TLE-DEBUG-TRACE-2\n";
+
+const std::string JSON_QUOTE                   = "\"";
+const std::string JSON_EQUAL                   = ":";
+const std::string JSON_SEPARATOR               = ",";
+const std::string JSON_ARRAY_OPEN              = "[";
+const std::string JSON_ARRAY_CLOSE             = "]";
+const std::string JSON_OBJECT_OPEN             = "{";
+const std::string JSON_OBJECT_CLOSE            = "}";
+const std::string JSON_RECORD_OPEN             = "{\"count\":";
+const std::string JSON_RECORD_DROPPED          = ",\"event\":\"dropped\"}\n";
+const std::string JSON_RECORD_SUPPRESSED       = ",\"event\":\"suppressed\"}\n";
+const std::string JSON_LINE_OPEN               = "{\"event\":\"line\",\"value\":\"";
+const std::string JSON_LINE_CLOSE              = "\"}";
+const std::string JSON_ELLIPSIS_OPEN           = "{\"more\":";
+const std::string JSON_ELLIPSIS_CLOSE          = "}";
+const std::string JSON_REMOVED_OPEN            = "{\"removed\":";
+const std::string JSON_REMOVED_CLOSE           = "}";
+const std::string JSON_NULL                    = "null";
+
+
+enum DEBUG_MODE
+{
+    DEBUG_SORTED    = 1 << 0,
+    DEBUG_WATCH     = 1 << 1,
+    DEBUG_SUMMARY   = 1 << 2,
+    DEBUG_FOOTPRINT = 1 << 3
+};
+
+enum DEBUG_SAMPLING
+{
+    DEBUG_HEAD_TAIL,
+    DEBUG_HEAD,
+    DEBUG_STRIDE
+};
+
+struct DEBUG_LIMIT
+{
+    size_t elements         = SIZE_MAX;
+    size_t depth            = SIZE_MAX;
+    size_t bytes            = SIZE_MAX;
+    DEBUG_SAMPLING sampling = DEBUG_HEAD_TAIL;
+};
+
+enum DEBUG_RATE
+{
+    DEBUG_EVERY,
+    DEBUG_FIRST,
+    DEBUG_PER_SECOND
+};
+
+enum DEBUG_LEVEL
+{
+    DEBUG_TRACE,
+    DEBUG_INFO,
+    DEBUG_WARN,
+    DEBUG_ERROR,
+    DEBUG_OFF
+};
+
+enum DEBUG_POLICY
+{
+    DEBUG_BLOCK,
+    DEBUG_DROP
+};
+
+enum DEBUG_STYLE
+{
+    DEBUG_AUTO,
+    DEBUG_COLORED,
+    DEBUG_PLAIN,
+    DEBUG_JSON
+};
+
+
+inline std::atomic<DEBUG_LEVEL> DEBUG_RUNTIME_LEVEL{DEBUG_TRACE};
+
+inline DEBUG_LIMIT DEBUG_DEFAULT_LIMIT;
+
+inline DEBUG_STYLE DEBUG_OUTPUT_STYLE = DEBUG_AUTO;
+
+
+class DEBUG_SINK
+{
+public:
+    virtual ~DEBUG_SINK() = default;
+
+    virtual void write(std::string_view _record) = 0;
+
+    virtual void write_all(const std::string_view* _records, size_t _count);
+
+    virtual void flush();
+
+    virtual bool terminal() const;
+};
+
+
+class STREAM_SINK : public DEBUG_SINK
+{
+private:
+    // System Variables
+    std::ostream& stream;
+    bool tty;
+
+public:
+    // Constructor
+    explicit STREAM_SINK(std::ostream& _stream);
+
+public:
+    // Output
+    void write(std::string_view _record) override;
+
+    void flush() override;
+
+    bool terminal() const override;
+};
+
+
+class RING_SINK : public DEBUG_SINK
+{
+private:
+    // System Variables
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t written = 0;
+
+#ifdef DEBUG_POSIX
+    static std::atomic<RING_SINK*> crash_sink;
+
+    static void dump_crash(int _signal);
+#endif
+
+public:
+    // Constructor and Destructor
+    explicit RING_SINK(size_t _capacity);
+
+#ifdef DEBUG_POSIX
+    ~RING_SINK();
+#endif
+
+public:
+    // Output
+    void write(std::string_view _record) override;
+
+    void dump(std::ostream& _stream) const;
+
+#ifdef DEBUG_POSIX
+    void dump(int _fd) const;
+
+    void dump_on_crash();
+#endif
+};
+
+
+#ifdef DEBUG_POSIX
+class FD_SINK : public DEBUG_SINK
+{
+private:
+    // System Variables
+    int fd;
+    bool tty;
+
+    void write_fully(const char* _data, size_t _size);
+
+public:
+    // Constructor
+    explicit FD_SINK(int _fd);
+
+public:
+    // Output
+    void write(std::string_view _record) override;
+
+    void write_all(const std::string_view* _records, size_t _count) override;
+
+    bool terminal() const override;
+};
+
+
+class MMAP_SINK : public DEBUG_SINK
+{
+private:
+    // System Variables
+    int fd          = -1;
+    char* data      = nullptr;
+    size_t capacity = 0;
+    size_t size     = 0;
+    size_t dropped  = 0;
+
+    bool grow(size_t _bytes);
+
+public:
+    // Constructor and Destructor
+    MMAP_SINK(const char* _path, size_t _capacity);
+
+    ~MMAP_SINK();
+
+    MMAP_SINK(const MMAP_SINK&) = delete;
+    MMAP_SINK& operator= (const MMAP_SINK&) = delete;
+
+public:
+    // Output
+    void write(std::string_view _record) override;
+
+    void flush() override;
+
+    bool good() const;
+
+    size_t dropped_records() const;
+};
+#endif
+
+
+class DEBUG_SNAPSHOT
+{
+    friend class DEBUG;
+
+private:
+    // Variables
+    const std::string_view* labels = nullptr;
+    size_t label_count             = 0;
+    std::string data;
+
+public:
+    // Output
+    bool empty() const;
+
+    size_t size() const;
+
+    void print() const;
+};
+
 
 class DEBUG
 {
+    friend class LINE;
+    friend class PROBE;
+    friend class DEBUG_SNAPSHOT;
+
     template <typename T, typename = void>
     struct is_iterator : std::false_type {};
 
     template <typename T>
     struct is_iterator<T, std::void_t<typename std::iterator_traits<T>::iterator_category>> : std::true_type {};
 
+    template <typename _Tp>
+    struct is_number : std::bool_constant<
+        std::is_arithmetic_v<_Tp> &&
+        !std::is_same_v<_Tp, bool> &&
+        !std::is_same_v<_Tp, char> &&
+        !std::is_same_v<_Tp, signed char> &&
+        !std::is_same_v<_Tp, unsigned char> &&
+        !std::is_same_v<_Tp, wchar_t> &&
+        !std::is_same_v<_Tp, char16_t> &&
+        !std::is_same_v<_Tp, char32_t>> {};
+
+    template <typename _Tp, typename = void>
+    struct has_member_fields : std::false_type {};
+
+    template <typename _Tp>
+    struct has_member_fields<_Tp, std::void_t<decltype(std::declval<const _Tp&>().tle_debug_fields())>> : std::true_type {};
+
+    template <typename _Tp, typename = void>
+    struct has_fields : has_member_fields<_Tp> {};
+
+    template <typename _Tp>
+    struct has_fields<_Tp, std::void_t<decltype(tle_debug_fields(std::declval<const _Tp&>()))>> : std::true_type {};
+
+    template <typename _Tp, typename = void>
+    struct is_range : std::false_type {};
+
+    // A type whose elements are the type itself, such as std::filesystem::path, is not treated as a range.
+    template <typename _Tp>
+    struct is_range<_Tp, std::void_t<decltype(std::begin(std::declval<const _Tp&>())),
+                                     decltype(std::end(std::declval<const _Tp&>()))>> : std::bool_constant<
+        !std::is_same_v<std::remove_cv_t<std::remove_reference_t<decltype(*std::begin(std::declval<const _Tp&>()))>>, _Tp>> {};
+
+    template <typename _Tp, typename = void>
+    struct has_size : std::false_type {};
+
+    template <typename _Tp>
+    struct has_size<_Tp, std::void_t<decltype(std::size(std::declval<const _Tp&>()))>> : std::true_type {};
+
+    template <typename _Tp, typename = void>
+    struct is_contiguous : std::false_type {};
+
+    template <typename _Tp>
+    struct is_contiguous<_Tp, std::void_t<decltype(std::data(std::declval<const _Tp&>())),
+                                          decltype(std::size(std::declval<const _Tp&>()))>> : std::true_type {};
+
+    template <typename _Tp>
+    using range_value = std::remove_cv_t<std::remove_reference_t<decltype(*std::begin(std::declval<const _Tp&>()))>>;
+
+    template <typename _Tp>
+    struct adaptor : _Tp
+    {
+        static const typename _Tp::container_type& container(const _Tp& _item)
+            { return _item.*(&adaptor::c); }
+
+        static const auto& compare(const _Tp& _item)
+            { return _item.*(&adaptor::comp); }
+    };
+
+    template <typename _Tp, typename = void>
+    struct is_adaptor : std::false_type {};
+
+    template <typename _Tp>
+    struct is_adaptor<_Tp, std::void_t<typename _Tp::container_type>> : std::bool_constant<!is_range<_Tp>::value> {};
+
+    template <typename _Tp, typename = void>
+    struct has_capacity : std::false_type {};
+
+    template <typename _Tp>
+    struct has_capacity<_Tp, std::void_t<decltype(std::declval<const _Tp&>().capacity())>> : std::true_type {};
+
+    template <typename _Tp, typename = void>
+    struct has_buckets : std::false_type {};
+
+    template <typename _Tp>
+    struct has_buckets<_Tp, std::void_t<decltype(std::declval<const _Tp&>().bucket_count())>> : std::true_type {};
+
+    enum class kind : unsigned char
+    {
+        pair,
+        tuple,
+        vector,
+        set,
+        multiset,
+        map,
+        multimap,
+        unordered_set,
+        unordered_multiset,
+        unordered_map,
+        unordered_multimap,
+        stack,
+        queue,
+        deque,
+        priority_queue,
+        tree,
+        structure,
+        range
+    };
+
+    static constexpr std::string_view kind_names[] = {
+        "pair", "tuple", "vector", "set", "multiset", "map", "multimap", "unordered_set", "unordered_multiset",
+        "unordered_map", "unordered_multimap", "stack", "queue", "deque", "priority_queue", "tree", "structure", "range"};
+
+    struct token_set
+    {
+        std::string open;
+        std::string separator;
+        std::string close;
+    };
+
+    struct palette
+    {
+        std::string heading;
+        std::string equal;
+        std::string unfold;
+        std::string record_open;
+        std::string record_close;
+        std::string record_dropped;
+        std::string record_suppressed;
+        std::string label_open;
+        std::string label_close;
+        std::string pointer_mark;
+        std::string iterator_mark;
+        std::string ellipsis_open;
+        std::string ellipsis_close;
+        std::string removed_open;
+        std::string removed_close;
+        token_set containers[static_cast<size_t>(kind::range) + 1];
+    };
+
+    struct format_state
+    {
+        std::ios_base::fmtflags flags = std::ios_base::dec;
+        std::streamsize precision     = 6;
+        std::streamsize width         = 0;
+        char fill                     = ' ';
+        std::locale locale;
+        bool captured = false;
+    };
+
+    struct watch_state
+    {
+        static constexpr size_t CHUNK = 64;
+
+        // Only fingerprints are kept: one per element in order and one per CHUNK numbers for positional
+        // containers, and for keyed containers the fingerprints sorted together with their position. The
+        // text of the element being compared is the only text held.
+        uint64_t fingerprint = 0;
+        std::vector<uint64_t> elements;
+        std::vector<uint64_t> chunks;
+        std::vector<std::pair<uint64_t, size_t>> keys;
+        std::vector<std::pair<uint64_t, size_t>> scratch_keys;
+        std::vector<size_t> removed;
+        std::string text;
+        bool seen = false;
+    };
+
+    template <typename _Tp>
+    struct summary
+    {
+        using sum_type = std::conditional_t<std::is_floating_point_v<_Tp>,
+                             std::conditional_t<(sizeof(_Tp) > sizeof(double)), long double, double>,
+                             std::conditional_t<std::is_signed_v<_Tp>, int64_t, uint64_t>>;
+
+        // Floats and doubles are read a vector at a time, other numbers one at a time.
+        static constexpr bool vectorized = DEBUG_VECTOR_BYTES && (std::is_same_v<_Tp, float> || std::is_same_v<_Tp, double>);
+#if DEBUG_VECTOR_BYTES
+        typedef float float_vector __attribute__((vector_size(DEBUG_VECTOR_BYTES)));
+        typedef double double_vector __attribute__((vector_size(DEBUG_VECTOR_BYTES)));
+        using pack = std::conditional_t<std::is_same_v<_Tp, float>, float_vector,
+                     std::conditional_t<std::is_same_v<_Tp, double>, double_vector, _Tp>>;
+#else
+        using pack = _Tp;
+#endif
+        using mask     = decltype(pack() < pack());
+        using counter  = std::conditional_t<vectorized, mask, size_t>;
+        using lane_sum = std::conditional_t<vectorized, pack, sum_type>;
+        using real     = std::conditional_t<vectorized, pack, double>;
+
+        static constexpr size_t WIDTH = sizeof(pack) / sizeof(_Tp);
+        static constexpr size_t BLOCK = 1024;
+        static constexpr size_t BINS  = 8;
+
+        size_t size    = 0;
+        size_t count   = 0;
+        size_t nan     = 0;
+        _Tp min        = std::numeric_limits<_Tp>::max();
+        _Tp max        = std::numeric_limits<_Tp>::lowest();
+        sum_type sum   = 0;
+        double squares = 0;
+        std::array<size_t, BINS> histogram{};
+
+        template <typename _Pack>
+        static auto lane(const _Pack& _pack, size_t _index);
+
+        static pack load(const _Tp* _first, size_t _size);
+
+        static mask finite(const pack& _value);
+
+        static void tally(counter& _counter, const mask& _mask);
+
+        void reduce(const _Tp* _first, size_t _size);
+
+        void spread(const _Tp* _first, size_t _size);
+    };
+
+    struct output_buffer : std::streambuf
+    {
+        std::string* output = nullptr;
+
+        int_type overflow(int_type _c) override
+        {
+            if (!traits_type::eq_int_type(_c, traits_type::eof()))
+                *output += traits_type::to_char_type(_c);
+            return _c;
+        }
+
+        std::streamsize xsputn(const char* _s, std::streamsize _n) override
+        {
+            output->append(_s, _n);
+            return _n;
+        }
+    };
+
 private:
     // Variables
     bool hide_label       = false;
     bool force_horizontal = false;
     int unfold_depth      = 1;
+    int mode              = 0;
+    DEBUG_LIMIT limit     = DEBUG_DEFAULT_LIMIT;
 
 private:
     // System Variables
-    std::string indent = DEBUG_UNFOLD;
-    std::string label;
-    std::deque<std::string> labels{DEBUG_HEADING};
-    std::function<void()> delayed_print;
+    const std::string_view* labels = nullptr;
+    size_t label_count = 0;
+    size_t label_index = 0;
+    std::string output;
+    std::ostream* stream = nullptr;
+    std::string* stream_output = nullptr;
+    bool raw_numbers   = false;
+    bool fast_integral = false;
+    bool fast_floating = false;
+    std::chars_format floating_format = std::chars_format::general;
+    int floating_precision = 6;
+    const void* items = nullptr;
+    void (DEBUG::*delayed_print)(const void*) = nullptr;
     int depth = 1;
+    size_t nesting = 0;
+    bool binary = false;
+    bool json = false;
+    std::string_view item_type;
+    size_t record_thread = SIZE_MAX;
+    size_t record_sequence = SIZE_MAX;
+    watch_state* watched = nullptr;
+    size_t item_index = 0;
+    bool changed = false;
+    bool parallel_worker = false;
+    bool deferred = false;
+    uint64_t suppressed = 0;
+    const palette* colors = &colored_palette;
+
+    static const palette colored_palette;
+    static const palette plain_palette;
+    static const palette json_palette;
+    static std::atomic<bool> sink_terminal;
+    static std::mutex output_mutex;
+    static std::recursive_mutex watch_mutex;
+    static std::atomic<size_t> thread_count;
+    static std::atomic<size_t> record_count;
+
+private:
+    // Asynchronous Output
+    struct async_slot
+    {
+        std::atomic<size_t> sequence{0};
+        std::string record;
+        const std::string_view* labels = nullptr;
+        size_t label_count = 0;
+    };
+
+    struct async_queue
+    {
+        std::unique_ptr<async_slot[]> slots;
+        size_t capacity     = 0;
+        DEBUG_POLICY policy = DEBUG_BLOCK;
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+        std::atomic<size_t> dropped{0};
+        std::atomic<size_t> producers{0};
+        std::atomic<bool> running{false};
+        std::thread worker;
+
+        async_queue();
+        ~async_queue();
+    };
+
+    static async_queue& queue();
+
+    static std::shared_ptr<DEBUG_SINK>& current_sink();
+
+    static const palette& current_palette();
+
+    static palette make_palette(bool _plain);
+
+    static palette make_json_palette();
+
+    static std::string strip_colors(const std::string& _token);
+
+    static bool queue_record(std::string_view _record, const std::string_view* _labels = nullptr, size_t _label_count = 0);
+
+    static void push_record(std::string_view _record, const std::string_view* _labels, size_t _label_count);
+
+    static void render_slot(async_slot& _slot);
+
+    static void drain_records();
+
+private:
+    // Binary Output
+    enum class event : char
+    {
+        integer          = 'i',
+        unsigned_integer = 'u',
+        floating         = 'f',
+        long_floating    = 'g',
+        boolean          = 'b',
+        text             = 's',
+        pointer          = 'p',
+        iterator         = 't',
+        field            = 'n',
+        ellipsis         = 'e',
+        removed          = 'r',
+        numbers          = 'a',
+        open             = '(',
+        close            = ')'
+    };
+
+    enum class frame : char
+    {
+        labels = 'L',
+        record = 'R',
+        text   = 'T'
+    };
+
+    // Deeper containers and larger precisions in a trace are rejected instead of overflowing the stack of the
+    // decoder, which std::num_put uses to format a number.
+    static constexpr size_t MAX_REPLAY_NESTING   = 1024;
+    static constexpr int32_t MAX_REPLAY_PRECISION = 1024;
+
+    struct trace_state
+    {
+        std::atomic<std::FILE*> file{nullptr};
+        std::unordered_map<const std::string_view*, uint32_t> labels;
+
+        ~trace_state();
+    };
+
+    static trace_state& trace();
+
+    static void write_frame(std::FILE* _file, frame _frame, std::string_view _payload);
+
+    static void store_integer(char* _first, uint64_t _value, size_t _bytes);
+
+    static uint64_t get_integer(const char*& _cursor, size_t _bytes);
+
+    void write_trace();
+
+    void put_event(event _event);
+
+    void put_integer(uint64_t _value, size_t _bytes);
+
+    template <typename _Tp>
+    void put_number(const _Tp& _item);
+
+    template <typename _Tp>
+    void put_numbers(const _Tp* _item, size_t _size);
+
+    size_t begin_text();
+
+    void end_text(size_t _start);
+
+    void put_header();
+
+    static bool available(const char* _cursor, const char* _last, size_t _bytes);
+
+    bool replay_record(const char* _cursor, const char* _last);
+
+    bool render_record(const char* _cursor, const char* _last);
+
+    bool replay(const char*& _cursor, const char* _last);
+
+    bool replay_numbers(kind _kind, const char*& _cursor, const char* _last);
+
+    static void print_snapshot(const DEBUG_SNAPSHOT& _snapshot);
 
 private:
     // Main Control
-    void generate_labels(std::string _label);
+    void print_delayed();
+
+    static std::string& record_buffer();
+
+    static output_buffer& format_buffer();
+
+    static std::ostream& format_stream();
+
+    static size_t thread_id();
+
+    static const format_state& cout_format();
+
+    void prepare_format();
+
+    void prepare_numbers();
+
+    void print_record();
+
+    void print_record(size_t _thread, size_t _sequence);
+
+    void print_label();
+
+    void print_type(std::string_view _fallback);
+
+    template <typename _Tp>
+    static constexpr std::string_view scalar_type();
+
+    template <typename... _Tps>
+    void print_items(const void* _items);
+
+    template <typename _Tp>
+    void print_item(const _Tp& _item);
 
     template <typename _Tp>
     void print_output(const _Tp& _item);
@@ -151,36 +879,162 @@ private:
     void print_output(const _Tp& _item, const _Tps&... _items);
 
     // Print Opening and Closing
-    void print_open(const std::string& _label);
+    void print_open(kind _kind, size_t _size);
+
+    void print_close(kind _kind);
+
+    void print_indent();
+
+    void print_separator(kind _kind);
+
+    void print_mark(event _event);
 
-    void print_close(const std::string& _label);
+    void print_text(std::string_view _text);
+
+    static void print_escaped(std::string& _output, std::string_view _text);
+
+    void print_quoted(size_t _start);
+
+    void print_field(std::string_view _name);
 
     // Print Different Container
     template <typename _Tp1, typename _Tp2>
-    void print_content_pair(const std::string& _label, const std::pair<_Tp1, _Tp2>& _item);
+    void print_content_pair(kind _kind, const std::pair<_Tp1, _Tp2>& _item);
 
     template <typename... _Tps>
-    void print_content_tuple(const std::string& _label, const std::tuple<_Tps...>& _item);
+    void print_content_tuple(kind _kind, const std::tuple<_Tps...>& _item);
 
     template <typename _Tp> 
-    void print_content_container(const std::string& _label, const _Tp& _item);
+    void print_content_container(kind _kind, const _Tp& _item);
 
     template <typename _Tp> 
-    void print_content_query_front(const std::string& _label, const _Tp& _item);
+    void print_content_reversed(kind _kind, const _Tp& _item);
 
     template <typename _Tp> 
-    void print_content_query_top(const std::string& _label, const _Tp& _item);
+    void print_content_heap(kind _kind, const _Tp& _item);
+
+    template <bool _Indirect = false, typename _Iterator>
+    void print_content_range(kind _kind, _Iterator _first, _Iterator _last, size_t _size);
+
+    template <bool _Indirect, typename _Iterator>
+    void print_content_watch(kind _kind, _Iterator _first, _Iterator _last, size_t _size);
+
+    static std::map<std::pair<const std::string_view*, size_t>, watch_state>& watch_states();
+
+    bool use_parallel(size_t _size);
+
+    void prepare_worker(const DEBUG& _parent);
+
+    template <typename _Render>
+    void print_content_parallel(size_t _size, const _Render& _render);
+
+    size_t sample_head(size_t _size, bool _bidirectional);
+
+    void print_ellipsis(size_t _count);
+
+    void print_removed(size_t _position);
+
+    template <typename _Tp>
+    void print_content_numbers(kind _kind, const _Tp* _item, size_t _size);
+
+    template <typename _Alloc>
+    void print_content_bits(kind _kind, const std::vector<bool, _Alloc>& _item);
+
+    template <typename _Tp>
+    bool print_summary(const _Tp& _item);
+
+    template <typename _Tp>
+    bool print_footprint(const _Tp& _item);
+
+    template <typename _Tp>
+    static constexpr size_t node_size(size_t _links);
+
+    template <typename _Tp>
+    static size_t storage_size(const _Tp& _item);
+
+    template <typename _CharT, typename _Traits, typename _Alloc>
+    static size_t storage_size(const std::basic_string<_CharT, _Traits, _Alloc>& _item);
+
+    template <typename _Alloc>
+    static size_t storage_size(const std::vector<bool, _Alloc>& _item);
+
+    template <typename _Tp, typename _Alloc>
+    static size_t storage_size(const std::deque<_Tp, _Alloc>& _item);
+
+    template <typename _Tp, typename _Alloc>
+    static size_t storage_size(const std::list<_Tp, _Alloc>& _item);
+
+    template <typename _Key, typename _Compare, typename _Alloc>
+    static size_t storage_size(const std::set<_Key, _Compare, _Alloc>& _item);
+
+    template <typename _Key, typename _Compare, typename _Alloc>
+    static size_t storage_size(const std::multiset<_Key, _Compare, _Alloc>& _item);
+
+    template <typename _Key, typename _Tp, typename _Compare, typename _Alloc>
+    static size_t storage_size(const std::map<_Key, _Tp, _Compare, _Alloc>& _item);
+
+    template <typename _Key, typename _Tp, typename _Compare, typename _Alloc>
+    static size_t storage_size(const std::multimap<_Key, _Tp, _Compare, _Alloc>& _item);
+
+#ifdef DEBUG_PBDS
+    template <typename _Key, typename _Tp, typename _Compare, typename _Tag, typename _Alloc>
+    static size_t storage_size(const __gnu_pbds::tree<_Key, _Tp, _Compare, _Tag, __gnu_pbds::tree_order_statistics_node_update, _Alloc>& _item);
+#endif
+
+    template <typename _Tp>
+    static size_t heap_size(const _Tp& _item);
+
+    template <typename _Tp1, typename _Tp2>
+    static size_t heap_size(const std::pair<_Tp1, _Tp2>& _item);
+
+    template <typename... _Tps>
+    static size_t heap_size(const std::tuple<_Tps...>& _item);
+
+    template <typename _Tp>
+    static size_t range_size(const _Tp& _item);
+
+    size_t indent_size();
+
+    char* print_indent(char* _first);
+
+    template <typename _Labels, typename... _Tps>
+    void print_content_fields(const _Labels& _names, const std::tuple<_Tps...>& _item);
+
+    template <typename _Tp>
+    static auto fields(const _Tp& _item);
+
+    // Print Numbers
+    template <typename _Tp>
+    size_t number_width();
+
+    template <typename _Tp>
+    char* format_number(char* _first, char* _last, const _Tp& _item);
+
+    template <typename _Tp>
+    void print_number(const _Tp& _item);
 
     // Print Various Data Types
     template <typename _Tp>
-    void print(_Tp* _item);
+    void print(_Tp* const& _item);
 
     template <typename _Tp>
-    void print(const _Tp* _item);
+    void print(const _Tp* const& _item);
 
     template <typename _Tp>
     void print(const _Tp& _item);
 
+    template <typename _Tp>
+    void print_stream(const _Tp& _item);
+
+    template <typename _Tp>
+    void print_range(const _Tp& _item);
+
+    template <typename _Tp, size_t _Nm>
+    void print(const _Tp (&_item)[_Nm]);
+
+    template <size_t _Nb>
+    void print(const std::bitset<_Nb>& _item);
+
     template <typename _Tp1, typename _Tp2>
     void print(const std::pair<_Tp1, _Tp2>& _item);
 
@@ -190,6 +1044,9 @@ private:
     template <typename _Tp, typename _Alloc>
     void print(const std::vector<_Tp, _Alloc>& _item);
 
+    template <typename _Alloc>
+    void print(const std::vector<bool, _Alloc>& _item);
+
     template <typename _Key, typename _Compare, typename _Alloc>
     void print(const std::set<_Key, _Compare, _Alloc>& _item);
 
@@ -226,14 +1083,59 @@ private:
     template <typename _Tp, typename _Sequence, typename _Compare>
     void print(const std::priority_queue<_Tp, _Sequence, _Compare>& _item);
 
+#ifdef DEBUG_PBDS
     template <typename _Key, typename _Tp, typename _Compare, typename _Tag, typename _Alloc>
     void print(const __gnu_pbds::tree<_Key, _Tp, _Compare, _Tag, __gnu_pbds::tree_order_statistics_node_update, _Alloc>& _item);
+#endif
+
+public:
+    // Output
+    static void write(std::string_view _record);
+
+    static void async(size_t _queue_depth = 1024, DEBUG_POLICY _policy = DEBUG_BLOCK);
+
+    static void flush();
+
+    static void shutdown();
+
+    static bool binary_trace(const char* _path);
+
+    static void sink(std::shared_ptr<DEBUG_SINK> _sink);
+
+    static bool decode(std::istream& _input);
+
+public:
+    // Label Parsing
+    template <size_t _Length>
+    struct label_text
+    {
+        char data[_Length]{};
+        size_t size = 0;
+    };
+
+    static constexpr bool split_label(char _c, int& _indent_depth, bool& _on_quote, bool& _on_double_quote);
+
+    template <size_t _Length>
+    static constexpr label_text<_Length> strip_labels(const char (&_label)[_Length]);
+
+    static constexpr size_t count_labels(std::string_view _label);
+
+    template <size_t _Count, size_t _Length>
+    static constexpr std::array<std::string_view, _Count> split_labels(const label_text<_Length>& _text);
+
+    template <typename... _Tps>
+    static std::tuple<_Tps...> capture_fields(_Tps&&... _fields);
+
+    template <typename... _Tps>
+    static std::tuple<const _Tps&...> capture_items(const _Tps&... _items);
 
 public:
     // Constructor and Destructor
     DEBUG();
-    template<typename... _Tps>
-    DEBUG(std::string _label, const _Tps&... _items);
+    template<size_t _Count, typename... _Tps>
+    DEBUG(const std::array<std::string_view, _Count>& _labels, const std::tuple<_Tps...>& _items);
+    template<size_t _Count, typename... _Tps>
+    DEBUG(const std::array<std::string_view, _Count>& _labels, const std::tuple<_Tps...>& _items, uint64_t _suppressed);
 
     ~DEBUG();
 
@@ -243,7 +1145,15 @@ public:
 
     DEBUG& operator() (const int& _unfold_depth);
 
+    DEBUG& operator() (const DEBUG_MODE& _mode);
+
+    DEBUG& operator() (const DEBUG_LIMIT& _limit);
+
     void operator-- (int _x);
+
+public:
+    // Snapshot
+    DEBUG_SNAPSHOT snapshot();
 };
 
 
@@ -268,10 +1178,10 @@ public:
 
 private:
     // Main Call
-    void print_output();
+    void print_output(std::string& _record);
 
     template <typename... _Tps>
-    void print_output(const std::string& _item, const _Tps&... _items);
+    void print_output(std::string& _record, const std::string& _item, const _Tps&... _items);
 
 public:
     // External Parameters
@@ -279,18 +1189,215 @@ public:
 };
 
 
+class PROBE
+{
+public:
+    enum class type : unsigned char { timer, counter };
+
+private:
+    // Histogram Layout
+    static constexpr size_t SUB_BITS    = 3;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static constexpr size_t BUCKETS     = (65 - SUB_BITS) * SUB_BUCKETS;
+
+    struct clock_origin
+    {
+        uint64_t ticks;
+        std::chrono::steady_clock::time_point time;
+    };
+
+private:
+    // Variables
+    std::string_view name;
+    type kind;
+    PROBE* next = nullptr;
+
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> minimum{UINT64_MAX};
+    std::atomic<uint64_t> maximum{0};
+    std::atomic<uint64_t> histogram[BUCKETS]{};
+
+private:
+    // System Variables
+    static std::atomic<PROBE*> probes;
+
+public:
+    // Constructor
+    PROBE(std::string_view _name, type _kind);
+
+    PROBE(const PROBE&) = delete;
+    PROBE& operator = (const PROBE&) = delete;
+
+private:
+    // Histogram
+    static size_t bucket(uint64_t _value);
+
+    static uint64_t bucket_value(size_t _bucket);
+
+    uint64_t percentile(const uint64_t (&_histogram)[BUCKETS], uint64_t _samples, uint64_t _permille) const;
+
+private:
+    // Clock
+    static const clock_origin& origin();
+
+    static double tick_length();
+
+private:
+    // Report
+    static std::string format_duration(double _nanoseconds);
+
+    void print_report(std::string& _output, double _tick_length) const;
+
+    static void exit_report();
+
+public:
+    // Main Control
+    static uint64_t now();
+
+    void add(uint64_t _value = 1);
+
+    static void report();
+};
+
+
+class TIMER
+{
+private:
+    // Variables
+    PROBE* probe;
+    uint64_t start = 0;
+
+public:
+    // Constructor and Destructor
+    explicit TIMER(PROBE* _probe);
+
+    TIMER(const TIMER&) = delete;
+    TIMER& operator = (const TIMER&) = delete;
+
+    ~TIMER();
+};
+
+
+class THROTTLE
+{
+private:
+    // Variables
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<int64_t> next{0};
+
+    static int64_t now();
+
+public:
+    // Main Control
+    uint64_t pass(DEBUG_RATE _rate, uint64_t _count);
+};
+
+
 // Main Calls
+/**
+*  @brief  Check whether a call of the given level should run.
+*  @param  _level  Level of the call.
+*
+*  Levels below DEBUG_MIN_LEVEL are folded away at compile time, the rest
+*  cost a single relaxed load of DEBUG_RUNTIME_LEVEL.
+*/
+#define DEBUG_ENABLED(_level)                                                                             \
+    ((_level) >= DEBUG_MIN_LEVEL && (_level) >= DEBUG_RUNTIME_LEVEL.load(std::memory_order_relaxed))
+
 /**
 *  @brief  Print lines with customizable pattern and length.
 *  @param  __VA_ARGS__  Patterns.
 */
-#define dline(...) LINE(__VA_ARGS__)
+#define dline(...) (DEBUG_ENABLED(DEBUG_INFO) ? LINE(__VA_ARGS__) : LINE())
+
+/**
+*  @brief  Split the stringized arguments of debug() into labels at compile time.
+*  @param  __VA_ARGS__  Items to debug.
+*/
+#define DEBUG_LABELS(...)                                                                                 \
+    []() -> const auto&                                                                                   \
+    {                                                                                                     \
+        static constexpr auto _text   = DEBUG::strip_labels(#__VA_ARGS__);                                \
+        static constexpr auto _labels = DEBUG::split_labels<DEBUG::count_labels(#__VA_ARGS__)>(_text);    \
+        return _labels;                                                                                   \
+    }()
+
+/**
+*  @brief  Print various data types if the given level is enabled.
+*  @param  _level       Level of the call.
+*  @param  __VA_ARGS__  Items to debug.
+*
+*  The items are not evaluated when the level is disabled.
+*/
+#define dlog(_level, ...)                                                                                 \
+    (DEBUG_ENABLED(_level) ? DEBUG(DEBUG_LABELS(__VA_ARGS__), DEBUG::capture_items(__VA_ARGS__)) : DEBUG())
 
 /**
 *  @brief  Print various data types.
 *  @param  __VA_ARGS__  Items to debug.
 */
-#define debug(...) DEBUG(#__VA_ARGS__, __VA_ARGS__)
+#define debug(...) dlog(DEBUG_INFO, __VA_ARGS__)
+
+/**
+*  @brief  Print various data types, at a rate limited per call site.
+*  @param  _rate        Policy of the call site.
+*  @param  _count       N of the policy.
+*  @param  __VA_ARGS__  Items to debug.
+*
+*  Throttled calls cost a few relaxed atomic operations and do not evaluate the items.
+*  Unlike debug(), it is a statement rather than an expression.
+*/
+#define dthrottle(_rate, _count, ...)                                                                     \
+    for (uint64_t _debug_pass = DEBUG_ENABLED(DEBUG_INFO) ?                                               \
+             []() -> THROTTLE& { static THROTTLE _site; return _site; }().pass(_rate, _count) : 0;        \
+         _debug_pass; _debug_pass = 0)                                                                    \
+        DEBUG(DEBUG_LABELS(__VA_ARGS__), DEBUG::capture_items(__VA_ARGS__), _debug_pass - 1)
+
+/**
+*  @brief  List the fields debug() prints for a user type, field by field.
+*  @param  __VA_ARGS__  Members (or any expressions using them) to print.
+*
+*  Place it inside the class. Types that cannot be changed can instead have a
+*  free function tle_debug_fields(const T&) found by ADL, returning the same
+*  pair of label array pointer and tuple of fields.
+*/
+#define DEBUG_FIELDS(...)                                                                                 \
+    auto tle_debug_fields() const                                                                         \
+        { return std::pair(&DEBUG_LABELS(__VA_ARGS__), DEBUG::capture_fields(__VA_ARGS__)); }
+
+
+/**
+*  @brief  Join two tokens after expanding them.
+*/
+#define DEBUG_JOIN_TOKENS(_first, _second) _first##_second
+#define DEBUG_JOIN(_first, _second) DEBUG_JOIN_TOKENS(_first, _second)
+
+/**
+*  @brief  Get the probe owned by the calling site.
+*  @param  _name  Name of the probe, a string literal.
+*  @param  _kind  Kind of the probe.
+*/
+#define DEBUG_PROBE(_name, _kind)                                                                         \
+    []() { static PROBE _probe(_name, _kind); return &_probe; }()
+
+/**
+*  @brief  Time the rest of the enclosing scope.
+*  @param  _name  Name of the timer, a string literal.
+*
+*  Samples of each call site are aggregated and reported at exit.
+*/
+#define dtime(_name)                                                                                      \
+    TIMER DEBUG_JOIN(_debug_timer_, __COUNTER__)(                                                         \
+        DEBUG_ENABLED(DEBUG_INFO) ? DEBUG_PROBE(_name, PROBE::type::timer) : nullptr)
+
+/**
+*  @brief  Count an event, or add a value to the distribution of the call site.
+*  @param  _name        Name of the counter, a string literal.
+*  @param  __VA_ARGS__  Value of the sample, 1 by default.
+*/
+#define dcount(_name, ...)                                                                                \
+    (DEBUG_ENABLED(DEBUG_INFO) ? DEBUG_PROBE(_name, PROBE::type::counter)->add(__VA_ARGS__) : void())
 
 
 #endif /* _TLE_DEBUG_H */
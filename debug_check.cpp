@@ -0,0 +1,254 @@
+// MIT License
+
+// Copyright (c) 2023 Ariyudo Pertama
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "bench.h"
+#include <climits>
+#include <iomanip>
+#include <sstream>
+
+
+// Check that every debug(...) and dline(...) record reaches the sink in a single write, that numbers
+// print as std::cout would print them and that repeated calls do not allocate, and report how fast
+// large containers are written. Build with:
+// g++ -std=c++17 -O2 -I<include> debug_check.cpp -o debug_check && ./debug_check
+
+static int failures = 0;
+
+static void check(bool _passed, const std::string& _what)
+{
+    if (!_passed)
+    {
+        failures++;
+        std::cerr << "FAILED: " << _what << '\n';
+    }
+}
+
+// Keeps the last record and counts the writes and bytes.
+class RECORD_SINK : public DEBUG_SINK
+{
+public:
+    size_t writes = 0;
+    size_t bytes  = 0;
+    std::string last;
+
+    void write(std::string_view _record) override
+    {
+        writes++;
+        bytes += _record.size();
+        last.assign(_record);
+    }
+};
+
+
+// Buffered Output
+static void check_buffering(RECORD_SINK& _sink)
+{
+    std::vector<std::vector<int>> grid(100, std::vector<int>(100, 7));
+    std::map<int, std::string> names = {{1, "one"}, {2, "two"}};
+
+    size_t writes = _sink.writes;
+    debug(grid);
+    debug(grid)(1);
+    debug(names, grid)(2);
+    dline("-");
+    dline("a", "b", "c")(25);
+    check(_sink.writes == writes + 5, "every debug(...) and dline(...) record is written at once");
+
+    std::vector<int> large(1000000);
+    for (size_t i = 0; i < large.size(); i++)
+        large[i] = value(i);
+    size_t bytes = _sink.bytes;
+    debug(large);
+    bytes = _sink.bytes - bytes;
+    std::printf("debug(vector<int>) of 10^6 elements: %.1f MB/s\n", bytes / time_call([&]() { debug(large); }) / 1e6);
+}
+
+
+// Number Formatting
+template <typename _Tp>
+static std::string stream_text(const _Tp& _value)
+{
+    std::ostringstream output;
+    output.copyfmt(std::cout);
+    output << _value;
+    return output.str();
+}
+
+static bool ends_with(std::string_view _text, std::string_view _suffix)
+{
+    return _text.size() >= _suffix.size() && _text.substr(_text.size() - _suffix.size()) == _suffix;
+}
+
+template <typename _Tp>
+static void check_number(RECORD_SINK& _sink, _Tp _value)
+{
+    debug(_value);
+    check(ends_with(_sink.last, " = " + stream_text(_value) + "\n"), "debug(" + stream_text(_value) + ") prints like std::cout");
+}
+
+template <typename _Tp>
+static void check_numbers(RECORD_SINK& _sink, const std::vector<_Tp>& _values)
+{
+    std::string expected = " = [";
+    for (_Tp value : _values)
+    {
+        check_number(_sink, value);
+        expected += stream_text(value) + ' ';
+    }
+    expected.back() = ']';
+
+    debug(_values);
+    check(ends_with(_sink.last, expected + '\n'), "debug(vector) prints like std::cout:" + expected);
+}
+
+static void check_numbers(RECORD_SINK& _sink)
+{
+    using limits = std::numeric_limits<double>;
+    std::ios saved(nullptr);
+    saved.copyfmt(std::cout);
+
+    // The fast path only handles some of these; the others must fall back to operator<< unchanged.
+    const std::vector<void (*)()> formats = {
+        []() {},
+        []() { std::cout << std::setprecision(17); },
+        []() { std::cout << std::fixed << std::setprecision(3); },
+        []() { std::cout << std::scientific; },
+        []() { std::cout << std::hexfloat; },
+        []() { std::cout << std::hex << std::showbase; },
+        []() { std::cout << std::showpos << std::showpoint; }
+    };
+    for (auto format : formats)
+    {
+        std::cout.copyfmt(saved);
+        format();
+        check_numbers<int>(_sink, {0, -1, 7, INT_MIN, INT_MAX});
+        check_numbers<long long>(_sink, {-42, 1000000007, LLONG_MIN, LLONG_MAX});
+        check_numbers<unsigned long long>(_sink, {0, 10, ULLONG_MAX});
+        check_numbers<short>(_sink, {-12345, SHRT_MAX});
+        check_numbers<double>(_sink, {0.0, -0.0, 0.1, 1.0 / 3, 123456.789, 1e300, 5e-324, limits::infinity(),
+                                      -limits::infinity(), limits::quiet_NaN()});
+        check_numbers<float>(_sink, {0.1f, -2.5f, 3e38f});
+        check_numbers<long double>(_sink, {0.1L, 1e4000L});
+    }
+    std::cout.copyfmt(saved);
+
+    std::vector<long long> large(1000000);
+    for (size_t i = 0; i < large.size(); i++)
+        large[i] = static_cast<long long>(i * 11400714819323198485u >> 2);
+    double seconds = time_call([&]() { debug(large); });
+
+    // The time std::to_chars alone takes for the same numbers, as a floor.
+    char buffer[32];
+    size_t length  = 0;
+    auto start     = std::chrono::steady_clock::now();
+    for (long long number : large)
+        length += std::to_chars(buffer, buffer + sizeof(buffer), number).ptr - buffer;
+    double floor = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("debug(vector<long long>) of 10^6 elements: %.1f ms, std::to_chars alone: %.1f ms for %zu bytes\n",
+                seconds * 1e3, floor * 1e3, length);
+}
+
+
+// Bit-Fields
+// A bit-field cannot be bound to a non-const reference, so every call has to capture its items by const reference.
+struct PACKED
+{
+    unsigned flag : 1;
+    int delta : 5;
+};
+
+static void check_bit_fields(RECORD_SINK& _sink)
+{
+    PACKED packed = {1, -3};
+    debug(packed.flag, packed.delta);
+    check(_sink.last.find("packed.flag = 1\n") != std::string::npos && ends_with(_sink.last, "packed.delta = -3\n"),
+          "debug(...) prints bit-fields");
+    dlog(DEBUG_ERROR, packed.delta);
+    check(ends_with(_sink.last, "packed.delta = -3\n"), "dlog(...) prints bit-fields");
+    dthrottle(DEBUG_EVERY, 1, packed.flag);
+    check(ends_with(_sink.last, "packed.flag = 1\n"), "dthrottle(...) prints bit-fields");
+}
+
+
+// Allocations
+// The first call on a thread sizes its record buffer; the calls after it should not allocate at all.
+template <typename _Call>
+static size_t count_allocations(_Call _call)
+{
+    _call();
+    size_t before = allocations;
+    for (int i = 0; i < 10; i++)
+        _call();
+    return allocations - before;
+}
+
+static void check_allocations()
+{
+    // Containers of at least DEBUG_PARALLEL_THRESHOLD elements may be formatted on several threads,
+    // which allocates once per call, so these stay below it.
+    std::vector<std::vector<std::vector<int>>> cube(10, std::vector<std::vector<int>>(10, std::vector<int>(10)));
+    std::map<int, std::vector<std::pair<int, double>>> table;
+    std::deque<std::set<long long>> sets(20);
+    std::unordered_map<std::string, std::tuple<int, char, bool>> names;
+    std::priority_queue<int> heap;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        cube[i / 100][i / 10 % 10][i % 10] = value(i);
+        table[value(i) % 50].emplace_back(value(i), i / 7.0);
+        sets[i % 20].insert(value(i));
+        heap.push(value(i));
+        if (i < 50)
+            names["name " + std::to_string(i)] = {value(i), static_cast<char>('a' + i % 26), i % 2};
+    }
+
+    check(count_allocations([&]() { debug(cube); }) == 0, "debug(cube) does not allocate");
+    check(count_allocations([&]() { debug(cube)(1); }) == 0, "debug(cube)(1) does not allocate");
+    check(count_allocations([&]() { debug(cube)(8); }) == 0, "debug(cube)(8) does not allocate");
+    check(count_allocations([&]() { debug(table)(8); }) == 0, "debug(table)(8) does not allocate");
+    check(count_allocations([&]() { debug(sets)(8); }) == 0, "debug(sets)(8) does not allocate");
+    check(count_allocations([&]() { debug(names)(8); }) == 0, "debug(names)(8) does not allocate");
+    check(count_allocations([&]() { debug(heap)(8); }) == 0, "debug(heap)(8) does not allocate");
+    check(count_allocations([&]() { debug(cube, table, sets, names, heap)(2); }) == 0,
+          "debug(cube, table, sets, names, heap)(2) does not allocate");
+}
+
+
+int main()
+{
+    auto sink = std::make_shared<RECORD_SINK>();
+    DEBUG::sink(sink);
+    check_buffering(*sink);
+    check_bit_fields(*sink);
+    check_numbers(*sink);
+    check_allocations();
+    DEBUG::sink(nullptr);
+
+    if (failures)
+    {
+        std::cerr << failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
@@ -0,0 +1,54 @@
+// MIT License
+
+// Copyright (c) 2023 Ariyudo Pertama
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <tle/debug>
+#include <fstream>
+
+
+// Render a binary trace written by DEBUG::binary_trace() as text, or as JSON lines with --json.
+int main(int argc, char* argv[])
+{
+    bool json = argc == 3 && std::string_view(argv[1]) == "--json";
+    if (argc != 2 && !json)
+    {
+        std::cerr << "usage: " << argv[0] << " [--json] <trace>\n";
+        return 2;
+    }
+
+    const char* path = argv[argc - 1];
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        std::cerr << argv[0] << ": cannot open " << path << '\n';
+        return 1;
+    }
+
+    if (json)
+        DEBUG_OUTPUT_STYLE = DEBUG_JSON;
+    if (!DEBUG::decode(input))
+    {
+        std::cerr << argv[0] << ": " << path << " is not a valid trace\n";
+        return 1;
+    }
+    return 0;
+}